@@ -0,0 +1,58 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include "Camera.h"
+
+
+
+Camera::Camera()
+	: mAspectRatio(1.f)
+	, mWidth(0)
+	, mHeight(0)
+	, mVersion(0)
+{
+	mat4x4_identity(mViewProj);
+}
+
+
+Camera::~Camera()
+{
+}
+
+void Camera::SetUp(GLFWwindow* aWindow)
+{
+	glfwSetWindowUserPointer(aWindow, this);
+	glfwSetFramebufferSizeCallback(aWindow, FramebufferSizeCallback);
+
+	int width, height;
+	glfwGetFramebufferSize(aWindow, &width, &height);
+	if (Resize(width, height))
+	{
+		glViewport(0, 0, width, height);
+	}
+}
+
+bool Camera::Resize(int aWidth, int aHeight)
+{
+	// minimized windows report 0x0, keep the last projection
+	if (aWidth <= 0 || aHeight <= 0 || (aWidth == mWidth && aHeight == mHeight))
+	{
+		return false;
+	}
+
+	mWidth = aWidth;
+	mHeight = aHeight;
+	mAspectRatio = static_cast<float>(aWidth) / aHeight;
+	mat4x4_ortho(mViewProj, -mAspectRatio, mAspectRatio, -1.f, 1.f, 1.f, -1.f);
+	mVersion++;
+	return true;
+}
+
+void Camera::FramebufferSizeCallback(GLFWwindow* aWindow, int aWidth, int aHeight)
+{
+	auto* camera = static_cast<Camera*>(glfwGetWindowUserPointer(aWindow));
+	if (camera != nullptr && camera->Resize(aWidth, aHeight))
+	{
+		glViewport(0, 0, aWidth, aHeight);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include "linmath.h"
+
+// Orthographic view of the [-aspect, aspect] x [-1, 1] play field.
+// The projection is only rebuilt when the framebuffer is resized.
+class Camera
+{
+public:
+	Camera();
+	~Camera();
+	// installs the framebuffer size callback (uses the window user pointer)
+	void SetUp(GLFWwindow* aWindow);
+	// only rebuilds the projection, returns false when nothing changed
+	bool Resize(int aWidth, int aHeight);
+
+	float GetAspectRatio() const { return mAspectRatio; }
+	// linmath takes non-const matrices, treat the result as read only
+	vec4* GetViewProj() { return mViewProj; }
+	// incremented every time the projection changes
+	int GetVersion() const { return mVersion; }
+
+private:
+	static void FramebufferSizeCallback(GLFWwindow* aWindow, int aWidth, int aHeight);
+
+	mat4x4 mViewProj;
+	float mAspectRatio;
+	int mWidth;
+	int mHeight;
+	int mVersion;
+};
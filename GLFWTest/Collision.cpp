@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Collision.h"
+
+
+
+namespace
+{
+	float Sign(float aValue)
+	{
+		return aValue < 0 ? -1.f : 1.f;
+	}
+
+	// a circle already touching the box: out along the shallowest direction
+	void PushOut(const Vec2& aRelative, float aRadius, const Vec2& aBoxCenter, const Vec2& aBoxHalf, SweepHit& aHit)
+	{
+		const float outsideX = std::fabs(aRelative.x) - aBoxHalf.x;
+		const float outsideY = std::fabs(aRelative.y) - aBoxHalf.y;
+		aHit.time = 0;
+		if (outsideX > 0 && outsideY > 0)
+		{
+			// next to a corner
+			const float distance = std::sqrt(outsideX * outsideX + outsideY * outsideY);
+			aHit.normal = { Sign(aRelative.x) * outsideX / distance, Sign(aRelative.y) * outsideY / distance };
+			aHit.position = { aBoxCenter.x + Sign(aRelative.x) * aBoxHalf.x + aHit.normal.x * aRadius,
+				aBoxCenter.y + Sign(aRelative.y) * aBoxHalf.y + aHit.normal.y * aRadius };
+		}
+		else if (outsideX > outsideY)
+		{
+			aHit.normal = { Sign(aRelative.x), 0 };
+			aHit.position = { aBoxCenter.x + aHit.normal.x * (aBoxHalf.x + aRadius), aBoxCenter.y + aRelative.y };
+		}
+		else
+		{
+			aHit.normal = { 0, Sign(aRelative.y) };
+			aHit.position = { aBoxCenter.x + aRelative.x, aBoxCenter.y + aHit.normal.y * (aBoxHalf.y + aRadius) };
+		}
+	}
+}
+
+
+
+bool SweepCircleBox(const Vec2& aStart, const Vec2& aMotion, float aRadius,
+	const Vec2& aBoxCenter, const Vec2& aBoxHalf, SweepHit& aHit)
+{
+	// everything relative to the box centre
+	const Vec2 relative = { aStart.x - aBoxCenter.x, aStart.y - aBoxCenter.y };
+	const float outsideX = std::max(std::fabs(relative.x) - aBoxHalf.x, 0.f);
+	const float outsideY = std::max(std::fabs(relative.y) - aBoxHalf.y, 0.f);
+	if (outsideX * outsideX + outsideY * outsideY < aRadius * aRadius)
+	{
+		PushOut(relative, aRadius, aBoxCenter, aBoxHalf, aHit);
+		return true;
+	}
+
+	if (aMotion.x == 0 && aMotion.y == 0)
+	{
+		return false;
+	}
+
+	// the centre against the box grown by the radius (slab test)
+	const float grown[2] = { aBoxHalf.x + aRadius, aBoxHalf.y + aRadius };
+	const float start[2] = { relative.x, relative.y };
+	const float motion[2] = { aMotion.x, aMotion.y };
+	float enter = -1.f;
+	float exit = 2.f;
+	int enterAxis = 0;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (motion[axis] == 0)
+		{
+			if (std::fabs(start[axis]) >= grown[axis])
+			{
+				return false;
+			}
+			continue;
+		}
+		const float slabEnter = (-Sign(motion[axis]) * grown[axis] - start[axis]) / motion[axis];
+		const float slabExit = (Sign(motion[axis]) * grown[axis] - start[axis]) / motion[axis];
+		if (slabEnter > enter)
+		{
+			enter = slabEnter;
+			enterAxis = axis;
+		}
+		exit = std::min(exit, slabExit);
+	}
+	if (enter > exit || enter > 1.f || exit < 0.f)
+	{
+		return false;
+	}
+	enter = std::max(enter, 0.f);
+
+	const Vec2 contact = { relative.x + aMotion.x * enter, relative.y + aMotion.y * enter };
+	if (std::fabs(contact.x) > aBoxHalf.x && std::fabs(contact.y) > aBoxHalf.y)
+	{
+		// the grown box has round corners: the circle around the box corner
+		// decides, a line that misses it misses the whole shape
+		const Vec2 corner = { Sign(contact.x) * aBoxHalf.x, Sign(contact.y) * aBoxHalf.y };
+		const Vec2 fromCorner = { relative.x - corner.x, relative.y - corner.y };
+		const float a = aMotion.x * aMotion.x + aMotion.y * aMotion.y;
+		const float b = fromCorner.x * aMotion.x + fromCorner.y * aMotion.y;
+		const float c = fromCorner.x * fromCorner.x + fromCorner.y * fromCorner.y - aRadius * aRadius;
+		const float discriminant = b * b - a * c;
+		// moving away from the corner, or passing it by
+		if (b >= 0 || discriminant < 0)
+		{
+			return false;
+		}
+		const float time = (-b - std::sqrt(discriminant)) / a;
+		if (time > 1.f)
+		{
+			return false;
+		}
+		const Vec2 normal = { fromCorner.x + aMotion.x * time, fromCorner.y + aMotion.y * time };
+		const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+		aHit.time = time;
+		aHit.position = { aStart.x + aMotion.x * time, aStart.y + aMotion.y * time };
+		aHit.normal = { normal.x / length, normal.y / length };
+		return true;
+	}
+
+	// the face the centre is on; a circle resting on it and moving off
+	// never touches
+	const Vec2 normal = enterAxis == 0 ? Vec2{ Sign(contact.x), 0 } : Vec2{ 0, Sign(contact.y) };
+	if (aMotion.x * normal.x + aMotion.y * normal.y >= 0)
+	{
+		return false;
+	}
+	aHit.time = enter;
+	aHit.position = { aStart.x + aMotion.x * enter, aStart.y + aMotion.y * enter };
+	aHit.normal = normal;
+	return true;
+}
+
+Vec2 Reflect(const Vec2& aVector, const Vec2& aNormal)
+{
+	const float dot = aVector.x * aNormal.x + aVector.y * aNormal.y;
+	if (dot >= 0)
+	{
+		return aVector;
+	}
+	return{ aVector.x - 2 * dot * aNormal.x, aVector.y - 2 * dot * aNormal.y };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Vec2.h"
+
+struct SweepHit
+{
+	float time;    // 0..1 along the motion
+	Vec2 position; // centre of the circle at the contact
+	Vec2 normal;   // unit, out of the box
+};
+
+// Moves a circle of aRadius from aStart by aMotion against a box given by
+// its centre and half size, and finds the first contact on the way, so a
+// fast circle cannot pass through a thin box within one step. A circle
+// that already overlaps the box at aStart hits at time 0, pushed out
+// along the shallowest direction. Returns false when they never touch,
+// including a circle resting on the box and moving away from it.
+bool SweepCircleBox(const Vec2& aStart, const Vec2& aMotion, float aRadius,
+	const Vec2& aBoxCenter, const Vec2& aBoxHalf, SweepHit& aHit);
+
+// aVector mirrored at the surface with aNormal, if it points into it
+Vec2 Reflect(const Vec2& aVector, const Vec2& aNormal);
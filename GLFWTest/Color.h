@@ -0,0 +1,7 @@
+#pragma once
+
+// linear rgba, 0..1
+struct Color
+{
+	float r, g, b, a;
+};
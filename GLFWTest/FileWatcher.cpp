@@ -0,0 +1,187 @@
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sys/stat.h>
+
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace
+{
+	// checks for new files and Stop() at least this often
+	const int POLL_INTERVAL_MS = 250;
+
+	long long GetModifiedTime(const std::string& aPath)
+	{
+		struct stat status;
+		return stat(aPath.c_str(), &status) == 0 ? static_cast<long long>(status.st_mtime) : 0;
+	}
+}
+
+
+
+FileWatcher& FileWatcher::Get()
+{
+	static FileWatcher sInstance;
+	return sInstance;
+}
+
+FileWatcher::FileWatcher()
+	: mRunning(false)
+{
+}
+
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+void FileWatcher::Start()
+{
+	if (mRunning)
+	{
+		return;
+	}
+	mRunning = true;
+	mThread = std::thread(&FileWatcher::Run, this);
+}
+
+void FileWatcher::Stop()
+{
+	mRunning = false;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+}
+
+void FileWatcher::Watch(const std::string& aPath)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (const auto& file : mFiles)
+	{
+		if (file.path == aPath)
+		{
+			return;
+		}
+	}
+	const size_t slash = aPath.find_last_of("/\\");
+	File file;
+	file.path = aPath;
+	file.directory = slash == std::string::npos ? "." : aPath.substr(0, slash);
+	file.name = slash == std::string::npos ? aPath : aPath.substr(slash + 1);
+	file.version = 1;
+	file.modified = GetModifiedTime(aPath);
+	mFiles.push_back(file);
+}
+
+unsigned FileWatcher::GetVersion(const std::string& aPath) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (const auto& file : mFiles)
+	{
+		if (file.path == aPath)
+		{
+			return file.version;
+		}
+	}
+	return 0;
+}
+
+void FileWatcher::Changed(const std::string& aDirectory, const std::string& aName)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto& file : mFiles)
+	{
+		if (file.directory == aDirectory && file.name == aName)
+		{
+			file.version++;
+		}
+	}
+}
+
+#ifdef __linux__
+void FileWatcher::Run()
+{
+	const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0)
+	{
+		std::cerr << "FileWatcher: inotify_init1 failed\n";
+		mRunning = false;
+		return;
+	}
+
+	std::map<int, std::string> directories; // watch descriptor -> directory
+	while (mRunning)
+	{
+		// directories of files watched since the last pass
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (const auto& file : mFiles)
+			{
+				bool watched = false;
+				for (const auto& directory : directories)
+				{
+					watched = watched || directory.second == file.directory;
+				}
+				if (!watched)
+				{
+					// IN_CLOSE_WRITE rather than IN_MODIFY: never reload half written files
+					const int wd = inotify_add_watch(fd, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+					if (wd >= 0)
+					{
+						directories[wd] = file.directory;
+					}
+				}
+			}
+		}
+
+		pollfd request = { fd, POLLIN, 0 };
+		if (poll(&request, 1, POLL_INTERVAL_MS) <= 0)
+		{
+			continue;
+		}
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+		{
+			for (ssize_t offset = 0; offset < length; )
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				if (event->len > 0)
+				{
+					Changed(directories[event->wd], event->name);
+				}
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+	close(fd);
+}
+#else
+void FileWatcher::Run()
+{
+	while (mRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& file : mFiles)
+		{
+			const long long modified = GetModifiedTime(file.path);
+			if (modified != file.modified)
+			{
+				file.modified = modified;
+				file.version++;
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches files from a background thread and counts how often each one
+// was written. Linux uses inotify on the containing directories, so
+// editors that save by renaming a new file over the old one are seen
+// too; other platforms poll the modification times.
+// Readers compare GetVersion() with the value they last loaded.
+class FileWatcher
+{
+public:
+	static FileWatcher& Get();
+
+	~FileWatcher();
+	// without Start() versions never change
+	void Start();
+	void Stop();
+	bool IsRunning() const { return mRunning; }
+
+	void Watch(const std::string& aPath);
+	// bumped on every completed write, 0 for paths that are not watched
+	unsigned GetVersion(const std::string& aPath) const;
+
+private:
+	struct File
+	{
+		std::string path;
+		std::string directory;
+		std::string name;
+		unsigned version;
+		long long modified; // polling only
+	};
+
+	FileWatcher();
+	void Run();
+	void Changed(const std::string& aDirectory, const std::string& aName);
+
+	mutable std::mutex mMutex;
+	std::vector<File> mFiles;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+};
@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include "FixedTimestep.h"
+
+
+
+FixedTimestep::FixedTimestep()
+	: mStep(1.0 / 60.0)
+	, mMaxSteps(5)
+	, mLastTime(0)
+	, mAccumulator(0)
+	, mDroppedTime(0)
+{
+}
+
+
+FixedTimestep::~FixedTimestep()
+{
+}
+
+void FixedTimestep::SetUp(double aHz, int aMaxSteps)
+{
+	mStep = 1.0 / std::max(aHz, 1.0);
+	mMaxSteps = std::max(aMaxSteps, 1);
+	mAccumulator = 0;
+	mDroppedTime = 0;
+}
+
+void FixedTimestep::Start(double aNow)
+{
+	mLastTime = aNow;
+	mAccumulator = 0;
+}
+
+int FixedTimestep::Advance(double aNow)
+{
+	// a clock going backwards adds nothing
+	mAccumulator += std::max(aNow - mLastTime, 0.0);
+	mLastTime = aNow;
+
+	int steps = static_cast<int>(mAccumulator / mStep);
+	if (steps > mMaxSteps)
+	{
+		mDroppedTime += (steps - mMaxSteps) * mStep;
+		mAccumulator -= (steps - mMaxSteps) * mStep;
+		steps = mMaxSteps;
+	}
+	// rounding must not leave a negative remainder
+	mAccumulator = std::max(mAccumulator - steps * mStep, 0.0);
+	return steps;
+}
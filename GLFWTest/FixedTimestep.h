@@ -0,0 +1,36 @@
+#pragma once
+
+// Turns elapsed time into a whole number of fixed simulation steps. The
+// time left over stays in an accumulator for the next call, so the
+// simulation runs at exactly aHz on average, whatever the caller's rate;
+// GetAlpha() tells how far the caller is between the last step and the
+// next one, for interpolating what it draws.
+//
+// After a hitch at most aMaxSteps are run and the rest of the backlog is
+// dropped, so a slow frame cannot make the next one slower still.
+class FixedTimestep
+{
+public:
+	FixedTimestep();
+	~FixedTimestep();
+	void SetUp(double aHz, int aMaxSteps = 5);
+	// times are in seconds from any clock, e.g. glfwGetTime()
+	void Start(double aNow);
+
+	// the number of steps due by aNow, zero or more
+	int Advance(double aNow);
+
+	// 0..1, the leftover time of the last Advance() in steps
+	double GetAlpha() const { return mAccumulator / mStep; }
+	// seconds per step
+	double GetStep() const { return mStep; }
+	// seconds of simulation dropped after hitches so far
+	double GetDroppedTime() const { return mDroppedTime; }
+
+private:
+	double mStep;
+	int mMaxSteps;
+	double mLastTime;
+	double mAccumulator;
+	double mDroppedTime;
+};
@@ -1,9 +1,34 @@
-R"delimiter(
-varying vec3 color;
+// sprite fragment shader, see Shader.cpp for the defines put in front
+varying vec2 vuv;
+varying vec4 vtint;
+uniform sampler2D texture;
+#ifdef CIRCLE
+varying vec2 vlocal; // -1..1 across the quad
 
-void main()
+// hue around the rim, white in the centre
+vec3 Rainbow(vec2 p)
 {
-	gl_FragColor = vec4(color, 1.0);
+	float r = length(p);
+	if (r < 0.0001) return vec3(1.0);
+	float t = atan(p.y, p.x) / 6.2831853;
+	vec3 phase = fract(vec3(t) + vec3(0.0, 1.0 / 3.0, 2.0 / 3.0));
+	vec3 rim = max(abs(phase * 2.0 - 1.0) * 3.0 - 1.0, 0.0);
+	// like the old vertex colour fan: unclamped until the output
+	return mix(vec3(1.0), rim, min(r, 1.0));
 }
+#endif
 
-)delimiter"
+void main(void)
+{
+#ifdef RAINBOW
+	vec4 color = vec4(Rainbow(vlocal), 1.0) * vtint;
+#else
+	vec4 color = texture2D(texture, vuv) * vtint;
+#endif
+#ifdef CIRCLE
+	// signed distance to the rim, faded over one pixel
+	float distance = length(vlocal) - 1.0;
+	color.a *= clamp(0.5 - distance / fwidth(distance), 0.0, 1.0);
+#endif
+	gl_FragColor = color;
+}
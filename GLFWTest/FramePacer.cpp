@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+
+#include "FramePacer.h"
+
+
+
+FramePacer::FramePacer()
+	: mMode(PACING_VSYNC)
+	, mFramePeriod(0)
+	, mStarted(false)
+	, mSleepEstimate(std::chrono::milliseconds(1))
+	, mSleepMean(0.001)
+	, mSleepVariance(0.0)
+	, mFrameCount(0)
+{
+}
+
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::SetUp(PacingMode aMode, double aTargetFps)
+{
+	mMode = aMode;
+	mFramePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(aTargetFps, 1.0)));
+	mStarted = false;
+	mFrameTimes.assign(HISTORY_SIZE, 0.f);
+	mFrameCount = 0;
+}
+
+void FramePacer::EndFrame()
+{
+	if (mMode == PACING_TARGET_FPS && mStarted)
+	{
+		mNextFrame += mFramePeriod;
+		const Clock::time_point now = Clock::now();
+		// after a stall start a new schedule instead of rushing to catch up
+		if (mNextFrame < now - mFramePeriod)
+		{
+			mNextFrame = now;
+		}
+		WaitUntil(mNextFrame);
+	}
+
+	const Clock::time_point now = Clock::now();
+	if (mStarted)
+	{
+		mFrameTimes[mFrameCount % HISTORY_SIZE] = std::chrono::duration<float, std::milli>(now - mLastFrame).count();
+		mFrameCount++;
+	}
+	else
+	{
+		mNextFrame = now;
+		mStarted = true;
+	}
+	mLastFrame = now;
+}
+
+void FramePacer::WaitUntil(Clock::time_point aDeadline)
+{
+	const auto sleepStep = std::chrono::milliseconds(1);
+	for (;;)
+	{
+		const Clock::time_point start = Clock::now();
+		if (start + mSleepEstimate >= aDeadline)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(sleepStep);
+		const double slept = std::chrono::duration<double>(Clock::now() - start).count();
+		// moving mean and variance; mean + 2 sigma covers all but the rare spikes
+		const double delta = slept - mSleepMean;
+		mSleepMean += delta / 16.0;
+		mSleepVariance += (delta * delta - mSleepVariance) / 16.0;
+		mSleepEstimate = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(mSleepMean + 2.0 * std::sqrt(mSleepVariance)));
+	}
+	while (Clock::now() < aDeadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+FramePacer::Statistics FramePacer::GetStatistics() const
+{
+	Statistics statistics = {};
+	const int count = std::min(mFrameCount, HISTORY_SIZE);
+	statistics.frameCount = count;
+	if (count == 0)
+	{
+		return statistics;
+	}
+
+	std::vector<float> frameTimes(mFrameTimes.begin(), mFrameTimes.begin() + count);
+	double sum = 0.0;
+	for (float frameTime : frameTimes)
+	{
+		sum += frameTime;
+	}
+	statistics.meanMs = sum / count;
+	double variance = 0.0;
+	for (float frameTime : frameTimes)
+	{
+		variance += (frameTime - statistics.meanMs) * (frameTime - statistics.meanMs);
+	}
+	statistics.jitterMs = std::sqrt(variance / count);
+
+	const auto p99 = frameTimes.begin() + std::min(count - 1, count * 99 / 100);
+	std::nth_element(frameTimes.begin(), p99, frameTimes.end());
+	statistics.p99Ms = *p99;
+	statistics.maxMs = *std::max_element(p99, frameTimes.end());
+	return statistics;
+}
+
+void FramePacer::Print(std::ostream& aStream) const
+{
+	static const char* const MODE_NAMES[] = { "vsync", "uncapped", "target fps" };
+	const Statistics statistics = GetStatistics();
+	aStream << "frame times (" << MODE_NAMES[mMode] << ", last " << statistics.frameCount << " frames): "
+		<< std::fixed << std::setprecision(3)
+		<< "mean " << statistics.meanMs << " ms, p99 " << statistics.p99Ms << " ms, max " << statistics.maxMs
+		<< " ms, jitter " << statistics.jitterMs << " ms\n";
+	aStream.unsetf(std::ios::floatfield);
+	aStream << std::setprecision(6);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+enum PacingMode
+{
+	// the swap waits for the display
+	PACING_VSYNC,
+	// as fast as possible
+	PACING_UNCAPPED,
+	// no vsync, FramePacer waits for a fixed frame rate itself
+	PACING_TARGET_FPS,
+};
+
+// Paces the render loop and records frame times. PACING_TARGET_FPS
+// sleeps in 1 ms steps while a sleep (mean + 2 sigma of the ones seen so
+// far) still fits before the deadline and spins for the rest, so coarse
+// OS timers cost some spinning instead of a late frame, and fine ones
+// cost little CPU. The schedule is absolute: a late frame does not push the later
+// ones back, unless it is more than a whole frame late.
+class FramePacer
+{
+public:
+	// frames kept for the statistics
+	static constexpr int HISTORY_SIZE = 1024;
+
+	struct Statistics
+	{
+		int frameCount;
+		double meanMs;
+		double p99Ms;
+		double maxMs;
+		double jitterMs; // standard deviation
+	};
+
+	FramePacer();
+	~FramePacer();
+	// aTargetFps is only used by PACING_TARGET_FPS
+	void SetUp(PacingMode aMode, double aTargetFps = 60.0);
+	// for glfwSwapInterval()
+	int GetSwapInterval() const { return mMode == PACING_VSYNC ? 1 : 0; }
+	PacingMode GetMode() const { return mMode; }
+
+	// after presenting: waits for the next frame's slot and records the frame time
+	void EndFrame();
+
+	// over the last HISTORY_SIZE frames
+	Statistics GetStatistics() const;
+	void Print(std::ostream& aStream) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void WaitUntil(Clock::time_point aDeadline);
+
+	PacingMode mMode;
+	Clock::duration mFramePeriod;
+	Clock::time_point mNextFrame;
+	Clock::time_point mLastFrame;
+	bool mStarted;
+	// how long a 1 ms sleep may take, learned from the sleeps so far
+	Clock::duration mSleepEstimate;
+	double mSleepMean; // seconds
+	double mSleepVariance;
+	std::vector<float> mFrameTimes; // ms, ring of HISTORY_SIZE
+	int mFrameCount;
+};
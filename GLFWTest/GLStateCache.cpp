@@ -0,0 +1,239 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <iomanip>
+
+#include "GLStateCache.h"
+
+
+
+GLStateCache& GLStateCache::Get()
+{
+	static GLStateCache instance;
+	return instance;
+}
+
+GLStateCache::GLStateCache()
+	: mIssuedCount(0)
+	, mSkippedCount(0)
+	, mIssuedTotal(0)
+	, mSkippedTotal(0)
+	, mFrameCount(0)
+{
+	Invalidate();
+}
+
+void GLStateCache::Invalidate()
+{
+	mProgramId = UNKNOWN;
+	mActiveUnit = UNKNOWN;
+	for (auto& texture : mTextures)
+	{
+		texture = UNKNOWN;
+	}
+	mArrayBuffer = UNKNOWN;
+	mElementArrayBuffer = UNKNOWN;
+	mVertexArray = UNKNOWN;
+	mBlendEnabled = -1;
+	mDepthTestEnabled = -1;
+	mBlendSrc = mBlendDst = UNKNOWN;
+	mUniforms.clear();
+}
+
+void GLStateCache::UseProgram(GLuint aProgramId)
+{
+	if (Changed(mProgramId != aProgramId))
+	{
+		mProgramId = aProgramId;
+		glUseProgram(aProgramId);
+	}
+}
+
+void GLStateCache::BindTexture(GLuint aUnit, GLuint aTexId)
+{
+	if (!Changed(aUnit >= TEXTURE_UNIT_MAX || mTextures[aUnit] != aTexId))
+	{
+		return;
+	}
+
+	if (mActiveUnit != aUnit)
+	{
+		mActiveUnit = aUnit;
+		glActiveTexture(GL_TEXTURE0 + aUnit);
+		mIssuedCount++;
+	}
+	if (aUnit < TEXTURE_UNIT_MAX)
+	{
+		mTextures[aUnit] = aTexId;
+	}
+	glBindTexture(GL_TEXTURE_2D, aTexId);
+}
+
+void GLStateCache::BindBuffer(GLenum aTarget, GLuint aBufferId)
+{
+	GLuint* bound = nullptr;
+	if (aTarget == GL_ARRAY_BUFFER)
+	{
+		bound = &mArrayBuffer;
+	}
+	else if (aTarget == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		bound = &mElementArrayBuffer;
+	}
+
+	if (Changed(bound == nullptr || *bound != aBufferId))
+	{
+		if (bound != nullptr)
+		{
+			*bound = aBufferId;
+		}
+		glBindBuffer(aTarget, aBufferId);
+	}
+}
+
+void GLStateCache::BindVertexArray(GLuint aVertexArrayId)
+{
+	if (!GLAD_GL_VERSION_3_0)
+	{
+		return;
+	}
+
+	if (Changed(mVertexArray != aVertexArrayId))
+	{
+		mVertexArray = aVertexArrayId;
+		glBindVertexArray(aVertexArrayId);
+		// the element buffer binding belongs to the vertex array
+		mElementArrayBuffer = UNKNOWN;
+	}
+}
+
+void GLStateCache::SetEnabled(GLenum aCap, bool aEnabled)
+{
+	int* enabled = nullptr;
+	if (aCap == GL_BLEND)
+	{
+		enabled = &mBlendEnabled;
+	}
+	else if (aCap == GL_DEPTH_TEST)
+	{
+		enabled = &mDepthTestEnabled;
+	}
+
+	if (Changed(enabled == nullptr || *enabled != static_cast<int>(aEnabled)))
+	{
+		if (enabled != nullptr)
+		{
+			*enabled = aEnabled;
+		}
+		if (aEnabled)
+		{
+			glEnable(aCap);
+		}
+		else
+		{
+			glDisable(aCap);
+		}
+	}
+}
+
+void GLStateCache::BlendFunc(GLenum aSrc, GLenum aDst)
+{
+	if (Changed(mBlendSrc != aSrc || mBlendDst != aDst))
+	{
+		mBlendSrc = aSrc;
+		mBlendDst = aDst;
+		glBlendFunc(aSrc, aDst);
+	}
+}
+
+void GLStateCache::Uniform1i(GLint aLocation, GLint aValue)
+{
+	if (UniformChanged(aLocation, &aValue, sizeof(aValue)))
+	{
+		glUniform1i(aLocation, aValue);
+	}
+}
+
+void GLStateCache::Uniform1f(GLint aLocation, GLfloat aValue)
+{
+	if (UniformChanged(aLocation, &aValue, sizeof(aValue)))
+	{
+		glUniform1f(aLocation, aValue);
+	}
+}
+
+void GLStateCache::Uniform4fv(GLint aLocation, const GLfloat* aValue)
+{
+	if (UniformChanged(aLocation, aValue, sizeof(GLfloat) * 4))
+	{
+		glUniform4fv(aLocation, 1, aValue);
+	}
+}
+
+void GLStateCache::UniformMatrix4fv(GLint aLocation, const GLfloat* aValue)
+{
+	if (UniformChanged(aLocation, aValue, sizeof(GLfloat) * 16))
+	{
+		glUniformMatrix4fv(aLocation, 1, false, aValue);
+	}
+}
+
+void GLStateCache::EndFrame()
+{
+	mIssuedTotal += mIssuedCount;
+	mSkippedTotal += mSkippedCount;
+	mFrameCount++;
+	mIssuedCount = 0;
+	mSkippedCount = 0;
+}
+
+void GLStateCache::Print(std::ostream& aStream)
+{
+	const long long total = mIssuedTotal + mSkippedTotal;
+	if (mFrameCount > 0 && total > 0)
+	{
+		aStream << "gl state calls per frame: " << std::fixed << std::setprecision(1)
+			<< static_cast<double>(mIssuedTotal) / mFrameCount << " issued, "
+			<< static_cast<double>(mSkippedTotal) / mFrameCount << " skipped ("
+			<< 100.0 * mSkippedTotal / total << "% saved)\n";
+		aStream.unsetf(std::ios::floatfield);
+		aStream << std::setprecision(6);
+	}
+	mIssuedTotal = 0;
+	mSkippedTotal = 0;
+	mFrameCount = 0;
+}
+
+bool GLStateCache::Changed(bool aChanged)
+{
+	if (aChanged)
+	{
+		mIssuedCount++;
+	}
+	else
+	{
+		mSkippedCount++;
+	}
+	return aChanged;
+}
+
+bool GLStateCache::UniformChanged(GLint aLocation, const void* aValue, size_t aSize)
+{
+	if (aLocation < 0)
+	{
+		return false;
+	}
+
+	const unsigned long long key = (static_cast<unsigned long long>(mProgramId) << 32) | static_cast<unsigned int>(aLocation);
+	auto found = mUniforms.find(key);
+	if (!Changed(mProgramId == UNKNOWN || found == mUniforms.end() || std::memcmp(found->second.data, aValue, aSize) != 0))
+	{
+		return false;
+	}
+
+	if (mProgramId != UNKNOWN)
+	{
+		std::memcpy(mUniforms[key].data, aValue, aSize);
+	}
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <ostream>
+#include <unordered_map>
+
+// Shadows the GL state the renderer touches and drops calls that would
+// not change anything. All binds of the program, textures, buffers,
+// vertex arrays, blend/depth state and uniforms should go through here,
+// otherwise call Invalidate() before relying on the cache again.
+class GLStateCache
+{
+public:
+	static constexpr int TEXTURE_UNIT_MAX = 16;
+
+	static GLStateCache& Get();
+
+	void Invalidate();
+
+	void UseProgram(GLuint aProgramId);
+	void BindTexture(GLuint aUnit, GLuint aTexId);
+	void BindBuffer(GLenum aTarget, GLuint aBufferId);
+	// no-op below GL 3.0, where only the default vertex array exists
+	void BindVertexArray(GLuint aVertexArrayId);
+	void SetEnabled(GLenum aCap, bool aEnabled);
+	void BlendFunc(GLenum aSrc, GLenum aDst);
+
+	// uniforms of the current program
+	void Uniform1i(GLint aLocation, GLint aValue);
+	void Uniform1f(GLint aLocation, GLfloat aValue);
+	void Uniform4fv(GLint aLocation, const GLfloat* aValue);
+	void UniformMatrix4fv(GLint aLocation, const GLfloat* aValue);
+
+	// adds this frame's counts to the totals for Print() and starts over
+	void EndFrame();
+	// average calls issued and skipped per frame since the last call, then
+	// starts over; prints nothing if no GL state went through the cache
+	void Print(std::ostream& aStream);
+
+	// calls forwarded to GL / dropped since the last EndFrame()
+	int mIssuedCount;
+	int mSkippedCount;
+
+private:
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	struct UniformValue
+	{
+		GLfloat data[16];
+	};
+
+	GLStateCache();
+	bool Changed(bool aChanged);
+	bool UniformChanged(GLint aLocation, const void* aValue, size_t aSize);
+
+	GLuint mProgramId;
+	GLuint mActiveUnit;
+	GLuint mTextures[TEXTURE_UNIT_MAX];
+	GLuint mArrayBuffer;
+	GLuint mElementArrayBuffer;
+	GLuint mVertexArray;
+	int mBlendEnabled; // -1: unknown
+	int mDepthTestEnabled;
+	GLenum mBlendSrc;
+	GLenum mBlendDst;
+	// since the last Print()
+	long long mIssuedTotal;
+	long long mSkippedTotal;
+	int mFrameCount;
+	// keyed by program << 32 | location
+	std::unordered_map<unsigned long long, UniformValue> mUniforms;
+};
@@ -0,0 +1,185 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <iomanip>
+
+#include "GpuProfiler.h"
+
+
+
+namespace
+{
+	double MillisecondsSince(std::chrono::steady_clock::time_point aStart)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count();
+	}
+}
+
+
+
+GpuProfiler::GpuProfiler()
+	: mDroppedFrameCount(0)
+	, mEnabled(false)
+	, mUseGpu(false)
+	, mFrameIndex(0)
+	, mFrameCount(0)
+{
+	for (auto& frame : mFrames)
+	{
+		frame.cpuMs = 0.0;
+		frame.pending = false;
+	}
+}
+
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+void GpuProfiler::SetUp(bool aUseGpu)
+{
+	mEnabled = true;
+	// GL_TIME_ELAPSED and 64-bit results are core since 3.3
+	mUseGpu = aUseGpu && GLAD_GL_VERSION_3_3;
+}
+
+void GpuProfiler::BeginFrame()
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+	Frame& frame = mFrames[mFrameIndex];
+	if (frame.pending)
+	{
+		// results arrive in order: the last query being done means all are
+		GLuint available = GL_TRUE;
+		if (mUseGpu)
+		{
+			glGetQueryObjectuiv(frame.queries[frame.passes.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		}
+		if (available == GL_TRUE)
+		{
+			Collect(frame);
+		}
+		else
+		{
+			mDroppedFrameCount++;
+		}
+	}
+	frame.passes.clear();
+	frame.pending = false;
+	mFrameStart = std::chrono::steady_clock::now();
+}
+
+void GpuProfiler::BeginPass(const char* aName)
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+	Frame& frame = mFrames[mFrameIndex];
+	if (mUseGpu)
+	{
+		if (frame.queries.size() <= frame.passes.size())
+		{
+			GLuint queryId = 0;
+			glGenQueries(1, &queryId);
+			frame.queries.push_back(queryId);
+		}
+		glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.passes.size()]);
+	}
+	frame.passes.push_back({ aName, 0.0, -1.0 });
+	mPassStart = std::chrono::steady_clock::now();
+}
+
+void GpuProfiler::EndPass()
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+	if (mUseGpu)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	mFrames[mFrameIndex].passes.back().cpuMs = MillisecondsSince(mPassStart);
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+	Frame& frame = mFrames[mFrameIndex];
+	frame.cpuMs = MillisecondsSince(mFrameStart);
+	frame.pending = true;
+	if (!mUseGpu || frame.passes.empty())
+	{
+		// nothing to wait for
+		Collect(frame);
+		frame.pending = false;
+	}
+	mFrameIndex = (mFrameIndex + 1) % FRAME_LATENCY;
+}
+
+void GpuProfiler::Collect(Frame& aFrame)
+{
+	double gpuMs = 0.0;
+	for (size_t i = 0; i < aFrame.passes.size(); i++)
+	{
+		PassTiming& pass = aFrame.passes[i];
+		if (mUseGpu)
+		{
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(aFrame.queries[i], GL_QUERY_RESULT, &nanoseconds);
+			pass.gpuMs = nanoseconds / 1000000.0;
+			gpuMs += pass.gpuMs;
+		}
+		Accumulate(pass.name, pass.cpuMs, pass.gpuMs);
+	}
+	// the frame's GPU time is the sum of its passes, work outside them is not seen
+	Accumulate("frame", aFrame.cpuMs, mUseGpu ? gpuMs : -1.0);
+	mFrameCount++;
+	mLatest = aFrame.passes;
+}
+
+void GpuProfiler::Accumulate(const char* aName, double aCpuMs, double aGpuMs)
+{
+	for (auto& total : mTotals)
+	{
+		if (std::strcmp(total.name, aName) == 0)
+		{
+			total.cpuMs += aCpuMs;
+			total.gpuMs += aGpuMs;
+			total.count++;
+			return;
+		}
+	}
+	mTotals.push_back({ aName, aCpuMs, aGpuMs, 1 });
+}
+
+void GpuProfiler::Print(std::ostream& aStream)
+{
+	if (mTotals.empty())
+	{
+		return;
+	}
+	aStream << "profile of " << mFrameCount << " frames (" << mDroppedFrameCount << " dropped), average ms:\n";
+	for (const auto& total : mTotals)
+	{
+		aStream << "  " << std::left << std::setw(10) << total.name << std::right << std::fixed << std::setprecision(3)
+			<< " cpu " << std::setw(8) << total.cpuMs / total.count;
+		if (mUseGpu)
+		{
+			aStream << "  gpu " << std::setw(8) << total.gpuMs / total.count;
+		}
+		aStream << "\n";
+	}
+	aStream.unsetf(std::ios::floatfield);
+	aStream << std::setprecision(6);
+	mTotals.clear();
+	mFrameCount = 0;
+	mDroppedFrameCount = 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+// Times named passes of a frame on the CPU and, with GL 3.3, on the GPU
+// with GL_TIME_ELAPSED queries. Each frame of the last FRAME_LATENCY has
+// its own set of query objects; results are read when that slot comes
+// round again, so reading them never waits for the GPU. A frame whose
+// results are still not there by then is dropped.
+// Passes cannot nest: only one GL_TIME_ELAPSED query may be active.
+// Every call is a no-op until SetUp().
+class GpuProfiler
+{
+public:
+	static constexpr int FRAME_LATENCY = 4;
+
+	struct PassTiming
+	{
+		const char* name; // not copied, use literals
+		double cpuMs;     // BeginPass() to EndPass() on the calling thread
+		double gpuMs;     // -1 without timer queries
+	};
+
+	GpuProfiler();
+	~GpuProfiler();
+	// aUseGpu false (software rasterizer, GL below 3.3) times the CPU only
+	void SetUp(bool aUseGpu);
+
+	void BeginFrame();
+	void BeginPass(const char* aName);
+	void EndPass();
+	void EndFrame();
+
+	// passes of the newest frame whose GPU times came back
+	const std::vector<PassTiming>& GetLatest() const { return mLatest; }
+	// averages per pass and per frame since the last call, then starts over
+	void Print(std::ostream& aStream);
+
+	int mDroppedFrameCount;
+
+private:
+	struct Frame
+	{
+		std::vector<PassTiming> passes;
+		std::vector<GLuint> queries; // one per pass, reused
+		double cpuMs;
+		bool pending;
+	};
+
+	struct Total
+	{
+		const char* name;
+		double cpuMs;
+		double gpuMs;
+		int count;
+	};
+
+	void Collect(Frame& aFrame);
+	void Accumulate(const char* aName, double aCpuMs, double aGpuMs);
+
+	bool mEnabled;
+	bool mUseGpu;
+	Frame mFrames[FRAME_LATENCY];
+	int mFrameIndex;
+	std::chrono::steady_clock::time_point mFrameStart;
+	std::chrono::steady_clock::time_point mPassStart;
+	std::vector<PassTiming> mLatest;
+	std::vector<Total> mTotals;
+	int mFrameCount;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+// 24-bit BGR pixels as stored in a BMP, bottom row first, rows tightly packed
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+};
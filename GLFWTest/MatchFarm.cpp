@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <thread>
+
+#include "MatchFarm.h"
+
+
+
+MatchFarm::MatchFarm()
+	: mThreadCount(1)
+	, mRemainingChunks(0)
+{
+}
+
+
+MatchFarm::~MatchFarm()
+{
+}
+
+void MatchFarm::SetUp(int aThreadCount)
+{
+	if (aThreadCount <= 0)
+	{
+		aThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	mThreadCount = aThreadCount;
+	mWorkers.clear();
+	for (int i = 0; i < mThreadCount; i++)
+	{
+		mWorkers.emplace_back(new Worker());
+	}
+}
+
+void MatchFarm::Run(long long aJobCount, const std::function<void(long long aJob, int aWorker)>& aJob)
+{
+	if (mWorkers.empty())
+	{
+		SetUp(mThreadCount);
+	}
+
+	// contiguous blocks of chunks, so that a worker's own jobs are neighbours
+	const long long chunkCount = (aJobCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	for (int i = 0; i < mThreadCount; i++)
+	{
+		Worker& worker = *mWorkers[i];
+		worker.chunks.clear();
+		worker.statistics = {};
+		const long long first = chunkCount * i / mThreadCount;
+		const long long last = chunkCount * (i + 1) / mThreadCount;
+		for (long long chunk = first; chunk < last; chunk++)
+		{
+			worker.chunks.push_back({ chunk * CHUNK_SIZE, std::min((chunk + 1) * CHUNK_SIZE, aJobCount) });
+		}
+	}
+	mRemainingChunks = chunkCount;
+
+	// the calling thread is worker 0
+	std::vector<std::thread> threads;
+	for (int i = 1; i < mThreadCount; i++)
+	{
+		threads.emplace_back(&MatchFarm::WorkerLoop, this, i, std::cref(aJob));
+	}
+	WorkerLoop(0, aJob);
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void MatchFarm::WorkerLoop(int aWorker, const std::function<void(long long, int)>& aJob)
+{
+	WorkerStatistics& statistics = mWorkers[aWorker]->statistics;
+	while (mRemainingChunks > 0)
+	{
+		Chunk chunk;
+		if (!PopOwn(aWorker, chunk))
+		{
+			if (!Steal(aWorker, chunk))
+			{
+				// the last chunks are being run by others
+				std::this_thread::yield();
+				continue;
+			}
+			statistics.stealCount++;
+		}
+
+		for (long long job = chunk.begin; job < chunk.end; job++)
+		{
+			aJob(job, aWorker);
+		}
+		statistics.jobCount += chunk.end - chunk.begin;
+		mRemainingChunks--;
+	}
+}
+
+bool MatchFarm::PopOwn(int aWorker, Chunk& aChunk)
+{
+	Worker& worker = *mWorkers[aWorker];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	if (worker.chunks.empty())
+	{
+		return false;
+	}
+	aChunk = worker.chunks.back();
+	worker.chunks.pop_back();
+	return true;
+}
+
+bool MatchFarm::Steal(int aWorker, Chunk& aChunk)
+{
+	// the next worker first, so thieves spread over different victims
+	for (int i = 1; i < mThreadCount; i++)
+	{
+		Worker& victim = *mWorkers[(aWorker + i) % mThreadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.chunks.empty())
+		{
+			aChunk = victim.chunks.front();
+			victim.chunks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a large number of independent jobs (matches, in PongSim) on every
+// hardware thread. The jobs are cut into chunks of CHUNK_SIZE and dealt
+// out in blocks, one deque per worker. A worker takes chunks from the
+// back of its own deque and, once that is empty, steals from the front of
+// another worker's, so workers that drew short matches help the others
+// instead of idling. Callers accumulate results per worker (the aWorker
+// argument) and merge them after Run().
+class MatchFarm
+{
+public:
+	static constexpr int CHUNK_SIZE = 64;
+
+	// per worker, for the last Run()
+	struct WorkerStatistics
+	{
+		long long jobCount;
+		int stealCount;
+	};
+
+	MatchFarm();
+	~MatchFarm();
+	// aThreadCount 0 uses every hardware thread, the caller's included
+	void SetUp(int aThreadCount = 0);
+
+	// calls aJob(job, worker) once for every job in 0..aJobCount-1 and
+	// returns when all are done; worker is 0..GetThreadCount()-1
+	void Run(long long aJobCount, const std::function<void(long long aJob, int aWorker)>& aJob);
+
+	int GetThreadCount() const { return mThreadCount; }
+	const WorkerStatistics& GetStatistics(int aWorker) const { return mWorkers[aWorker]->statistics; }
+
+private:
+	struct Chunk
+	{
+		long long begin;
+		long long end;
+	};
+
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Chunk> chunks;
+		WorkerStatistics statistics;
+	};
+
+	void WorkerLoop(int aWorker, const std::function<void(long long, int)>& aJob);
+	bool PopOwn(int aWorker, Chunk& aChunk);
+	bool Steal(int aWorker, Chunk& aChunk);
+
+	int mThreadCount;
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	// chunks not finished yet, the workers stop at 0
+	std::atomic<long long> mRemainingChunks;
+};
@@ -0,0 +1,92 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "GLStateCache.h"
+#include "Mesh.h"
+#include "Shader.h"
+
+
+
+Mesh::Mesh()
+	: mVertexArrayId(0)
+	, mMode(GL_TRIANGLE_FAN)
+	, mCount(0)
+	, mId(0)
+{
+}
+
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::SetUp(const Vec2* aVertex, const Vec2* aUv, int aCount, GLenum aMode, bool aUpload)
+{
+	static int sNextId = 1;
+	if (mId == 0)
+	{
+		mId = sNextId++;
+	}
+	mMode = aMode;
+	mCount = aCount;
+
+	// interleave as x, y, u, v
+	mVertices.clear();
+	mVertices.reserve(aCount * 4);
+	for (int i = 0; i < aCount; i++)
+	{
+		mVertices.push_back(aVertex[i].x);
+		mVertices.push_back(aVertex[i].y);
+		mVertices.push_back(aUv[i].x);
+		mVertices.push_back(aUv[i].y);
+	}
+	if (!aUpload)
+	{
+		mPackedVertices.clear();
+		return;
+	}
+
+	const VertexLayout& layout = Shader::GetVertexLayout();
+	mPackedVertices.assign(aCount * layout.GetStride(), 0);
+	for (int i = 0; i < aCount; i++)
+	{
+		if (std::fabs(aVertex[i].x) > 1.f || std::fabs(aVertex[i].y) > 1.f)
+		{
+			std::cerr << "Mesh: vertex " << i << " is outside -1..1 and gets clamped\n";
+		}
+		unsigned char* vertex = &mPackedVertices[i * layout.GetStride()];
+		layout.Pack(0, &mVertices[i * 4], vertex);
+		layout.Pack(1, &mVertices[i * 4 + 2], vertex);
+	}
+	mBuffer.SetUp(GL_ARRAY_BUFFER, mPackedVertices.data(), mPackedVertices.size());
+
+	// vertex arrays are core since 3.0
+	if (GLAD_GL_VERSION_3_0)
+	{
+		auto& state = GLStateCache::Get();
+		if (mVertexArrayId == 0)
+		{
+			glGenVertexArrays(1, &mVertexArrayId);
+		}
+		state.BindVertexArray(mVertexArrayId);
+		// the pointers capture the bound array buffer
+		mBuffer.Bind();
+		layout.Apply();
+		state.BindVertexArray(0);
+	}
+}
+
+void Mesh::Bind() const
+{
+	if (mVertexArrayId != 0)
+	{
+		GLStateCache::Get().BindVertexArray(mVertexArrayId);
+		return;
+	}
+
+	mBuffer.Bind();
+	Shader::GetVertexLayout().Apply();
+}
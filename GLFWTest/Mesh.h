@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <vector>
+#include "StaticBuffer.h"
+#include "Vec2.h"
+
+// Immutable local geometry (position + uv) kept in a static buffer in the
+// compact Shader::GetVertexLayout() format.
+// Objects using it only send their transform when drawn. With GL 3.0 the
+// attribute setup is recorded once in a vertex array object. A CPU copy
+// is kept for the software rasterizer, which also skips the upload.
+class Mesh
+{
+public:
+	Mesh();
+	~Mesh();
+	void SetUp(const Vec2* aVertex, const Vec2* aUv, int aCount, GLenum aMode = GL_TRIANGLE_FAN, bool aUpload = true);
+	// binds the vertex array, or the buffer and the attribute pointers
+	// when vertex arrays are not available
+	void Bind() const;
+
+	GLenum GetMode() const { return mMode; }
+	int GetCount() const { return mCount; }
+	// small id for render queue sort keys
+	int GetId() const { return mId; }
+	// 0 without vertex array objects
+	GLuint GetVertexArrayId() const { return mVertexArrayId; }
+	// four vertices as a fan: drawable through the QuadIndexBuffer
+	bool IsQuad() const { return mCount == 4 && mMode == GL_TRIANGLE_FAN; }
+	// interleaved x, y, u, v as floats
+	const std::vector<float>& GetVertices() const { return mVertices; }
+	// the uploaded vertices, empty when SetUp() skipped the upload
+	const std::vector<unsigned char>& GetPackedVertices() const { return mPackedVertices; }
+
+private:
+	StaticBuffer mBuffer;
+	GLuint mVertexArrayId;
+	std::vector<float> mVertices;
+	std::vector<unsigned char> mPackedVertices;
+	GLenum mMode;
+	int mCount;
+	int mId;
+};
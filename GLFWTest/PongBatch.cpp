@@ -0,0 +1,390 @@
+#include "PongBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PONG_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+// MSVC defines __AVX2__ with /arch:AVX2
+#if defined(__AVX2__)
+#define PONG_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+
+
+namespace
+{
+	// the vector kernels load the buttons of several matches at once
+	static_assert(sizeof(InputFrame) == sizeof(int), "InputFrame is one int");
+
+	constexpr float BAR0_X = -PongWorld::BAR_X;
+	constexpr float BAR1_X = +PongWorld::BAR_X;
+	constexpr float BAR_LIMIT = PongWorld::BAR_Y_LIMIT - PongWorld::BAR_HEIGHT / 2;
+
+	// the arrays of PongBatch, for the kernels
+	struct Lanes
+	{
+		float* ballX;
+		float* ballY;
+		float* dirX;
+		float* dirY;
+		float* bar0Y;
+		float* bar1Y;
+		int* leftPoint;
+		int* rightPoint;
+	};
+
+#ifdef PONG_BATCH_SSE2
+	struct Sse2
+	{
+		typedef __m128 F;
+		typedef __m128i I;
+		static constexpr int WIDTH = 4;
+
+		static F Load(const float* aSource) { return _mm_loadu_ps(aSource); }
+		static void Store(float* aDestination, F aValue) { _mm_storeu_ps(aDestination, aValue); }
+		static F Set(float aValue) { return _mm_set1_ps(aValue); }
+		static F Add(F a, F b) { return _mm_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm_div_ps(a, b); }
+		static F Min(F a, F b) { return _mm_min_ps(a, b); }
+		static F Max(F a, F b) { return _mm_max_ps(a, b); }
+		static F And(F a, F b) { return _mm_and_ps(a, b); }
+		static F AndNot(F aMask, F b) { return _mm_andnot_ps(aMask, b); }
+		static F Or(F a, F b) { return _mm_or_ps(a, b); }
+		static F Xor(F a, F b) { return _mm_xor_ps(a, b); }
+		static F Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+		static F Less(F a, F b) { return _mm_cmplt_ps(a, b); }
+		static F Equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+		static int MoveMask(F aMask) { return _mm_movemask_ps(aMask); }
+
+		static I LoadInt(const int* aSource) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource)); }
+		static void StoreInt(int* aDestination, I aValue) { _mm_storeu_si128(reinterpret_cast<__m128i*>(aDestination), aValue); }
+		static I SetInt(int aValue) { return _mm_set1_epi32(aValue); }
+		static I AndInt(I a, I b) { return _mm_and_si128(a, b); }
+		static I SubInt(I a, I b) { return _mm_sub_epi32(a, b); }
+		static I EqualInt(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+		static I AsInt(F aValue) { return _mm_castps_si128(aValue); }
+		static F AsFloat(I aValue) { return _mm_castsi128_ps(aValue); }
+	};
+#endif
+
+#ifdef PONG_BATCH_AVX2
+	struct Avx2
+	{
+		typedef __m256 F;
+		typedef __m256i I;
+		static constexpr int WIDTH = 8;
+
+		static F Load(const float* aSource) { return _mm256_loadu_ps(aSource); }
+		static void Store(float* aDestination, F aValue) { _mm256_storeu_ps(aDestination, aValue); }
+		static F Set(float aValue) { return _mm256_set1_ps(aValue); }
+		static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+		static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+		static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+		static F And(F a, F b) { return _mm256_and_ps(a, b); }
+		static F AndNot(F aMask, F b) { return _mm256_andnot_ps(aMask, b); }
+		static F Or(F a, F b) { return _mm256_or_ps(a, b); }
+		static F Xor(F a, F b) { return _mm256_xor_ps(a, b); }
+		static F Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static F Less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static F Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static int MoveMask(F aMask) { return _mm256_movemask_ps(aMask); }
+
+		static I LoadInt(const int* aSource) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSource)); }
+		static void StoreInt(int* aDestination, I aValue) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDestination), aValue); }
+		static I SetInt(int aValue) { return _mm256_set1_epi32(aValue); }
+		static I AndInt(I a, I b) { return _mm256_and_si256(a, b); }
+		static I SubInt(I a, I b) { return _mm256_sub_epi32(a, b); }
+		static I EqualInt(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+		static I AsInt(F aValue) { return _mm256_castps_si256(aValue); }
+		static F AsFloat(I aValue) { return _mm256_castsi256_ps(aValue); }
+	};
+#endif
+
+#if defined(PONG_BATCH_SSE2) || defined(PONG_BATCH_AVX2)
+	template <typename V>
+	typename V::F IsPressed(typename V::I aButtons, unsigned int aButton)
+	{
+		const typename V::I button = V::SetInt(static_cast<int>(aButton));
+		return V::AsFloat(V::EqualInt(V::AndInt(aButtons, button), button));
+	}
+
+	// PongWorld::MoveBar(): a bar that does not move stays in its limits
+	template <typename V>
+	typename V::F MoveBar(typename V::F aY, typename V::F aUp, typename V::F aDown)
+	{
+		const typename V::F delta = V::Or(V::And(aUp, V::Set(+PongWorld::BAR_SPEED)),
+			V::AndNot(aUp, V::And(aDown, V::Set(-PongWorld::BAR_SPEED))));
+		return V::Min(V::Max(V::Add(aY, delta), V::Set(-BAR_LIMIT)), V::Set(BAR_LIMIT));
+	}
+
+	template <typename V>
+	typename V::F Select(typename V::F aMask, typename V::F aIfSet, typename V::F aIfClear)
+	{
+		return V::Or(V::And(aMask, aIfSet), V::AndNot(aMask, aIfClear));
+	}
+
+	// SweepCircleBox() of the ball against one bar, for the hits it takes
+	// on the bar's face: aHit where the ball touches the face in this move,
+	// at aTime. aScalar where the answer needs the rest of SweepCircleBox(),
+	// a ball already touching the bar, not moving on an axis, or hitting
+	// the bar's end or corner. Operation for operation the scalar code, so
+	// the times come out the same.
+	template <typename V>
+	void SweepBar(typename V::F aX, typename V::F aY, typename V::F aMotionX, typename V::F aMotionY,
+		float aBarX, typename V::F aBarY, typename V::F& aHit, typename V::F& aScalar, typename V::F& aTime)
+	{
+		typedef typename V::F F;
+		const F signBit = V::Set(-0.f);
+		const F zero = V::Set(0.f);
+		const F one = V::Set(1.f);
+		const F halfX = V::Set(PongWorld::BAR_HIT_HALF_X);
+		const F halfY = V::Set(PongWorld::BAR_HIT_HALF_Y);
+		const F grownX = V::Set(PongWorld::BAR_HIT_HALF_X + PongWorld::BALL_HIT_HALF);
+		const F grownY = V::Set(PongWorld::BAR_HIT_HALF_Y + PongWorld::BALL_HIT_HALF);
+
+		const F relativeX = V::Sub(aX, V::Set(aBarX));
+		const F relativeY = V::Sub(aY, aBarY);
+		const F outsideX = V::Max(V::Sub(V::AndNot(signBit, relativeX), halfX), zero);
+		const F outsideY = V::Max(V::Sub(V::AndNot(signBit, relativeY), halfY), zero);
+		const F overlap = V::Less(V::Add(V::Mul(outsideX, outsideX), V::Mul(outsideY, outsideY)),
+			V::Set(PongWorld::BALL_HIT_HALF * PongWorld::BALL_HIT_HALF));
+		const F still = V::Or(V::Equal(aMotionX, zero), V::Equal(aMotionY, zero));
+
+		// slab test against the box grown by the radius; Sign() is -1 or 1
+		const F negativeX = V::Less(aMotionX, zero);
+		const F negativeY = V::Less(aMotionY, zero);
+		const F signX = Select<V>(negativeX, V::Set(-1.f), one);
+		const F signY = Select<V>(negativeY, V::Set(-1.f), one);
+		const F enterX = V::Div(V::Sub(V::Mul(V::Xor(signX, signBit), grownX), relativeX), aMotionX);
+		const F exitX = V::Div(V::Sub(V::Mul(signX, grownX), relativeX), aMotionX);
+		const F enterY = V::Div(V::Sub(V::Mul(V::Xor(signY, signBit), grownY), relativeY), aMotionY);
+		const F exitY = V::Div(V::Sub(V::Mul(signY, grownY), relativeY), aMotionY);
+		F enter = V::Set(-1.f);
+		enter = Select<V>(V::Greater(enterX, enter), enterX, enter);
+		const F enterAxisY = V::Greater(enterY, enter);
+		enter = Select<V>(enterAxisY, enterY, enter);
+		const F exit = V::Min(exitY, V::Min(exitX, V::Set(2.f)));
+		const F miss = V::Or(V::Greater(enter, exit), V::Or(V::Greater(enter, one), V::Less(exit, zero)));
+		enter = Select<V>(V::Less(enter, zero), zero, enter);
+
+		const F contactX = V::Add(relativeX, V::Mul(aMotionX, enter));
+		const F contactY = V::Add(relativeY, V::Mul(aMotionY, enter));
+		const F corner = V::And(V::Greater(V::AndNot(signBit, contactX), halfX),
+			V::Greater(V::AndNot(signBit, contactY), halfY));
+
+		// a ball resting on the face and moving off it does not hit
+		const F normalX = Select<V>(V::Less(contactX, zero), V::Set(-1.f), one);
+		const F into = V::Less(V::Mul(aMotionX, normalX), zero);
+
+		aScalar = V::Or(V::Or(overlap, still), V::AndNot(miss, V::Or(enterAxisY, corner)));
+		aHit = V::And(into, V::AndNot(V::Or(aScalar, miss), V::Equal(zero, zero)));
+		aTime = enter;
+	}
+
+	// PongWorld::Step() for V::WIDTH matches at a time, with masks in place
+	// of the branches. A match SweepBar() cannot settle is left as it was
+	// and added to aScalarMatches, for PongWorld. Returns the first match
+	// it did not step.
+	template <typename V>
+	int StepLanes(const Lanes& aLanes, const InputFrame* aInputs, int aBegin, int aEnd, std::vector<int>& aScalarMatches)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+		const F signBit = V::Set(-0.f);
+		const F zero = V::Set(0.f);
+		const F two = V::Set(2.f);
+		const F speed = V::Set(PongWorld::BALL_SPEED);
+
+		int i = aBegin;
+		for (; i + V::WIDTH <= aEnd; i += V::WIDTH)
+		{
+			const I buttons = V::LoadInt(reinterpret_cast<const int*>(aInputs + i));
+			const F lastBar0Y = V::Load(aLanes.bar0Y + i);
+			const F lastBar1Y = V::Load(aLanes.bar1Y + i);
+			const F bar0Y = MoveBar<V>(lastBar0Y, IsPressed<V>(buttons, BUTTON_LEFT_UP), IsPressed<V>(buttons, BUTTON_LEFT_DOWN));
+			const F bar1Y = MoveBar<V>(lastBar1Y, IsPressed<V>(buttons, BUTTON_RIGHT_UP), IsPressed<V>(buttons, BUTTON_RIGHT_DOWN));
+
+			// goal: the masks are -1, so subtracting them counts the point
+			const F lastX = V::Load(aLanes.ballX + i);
+			const F lastDirX = V::Load(aLanes.dirX + i);
+			const I lastLeftPoint = V::LoadInt(aLanes.leftPoint + i);
+			const I lastRightPoint = V::LoadInt(aLanes.rightPoint + i);
+			const F leftGoal = V::Greater(lastX, V::Set(+PongWorld::GOAL_X));
+			const F rightGoal = V::Less(lastX, V::Set(-PongWorld::GOAL_X));
+			const I leftPoint = V::SubInt(lastLeftPoint, V::AsInt(leftGoal));
+			const I rightPoint = V::SubInt(lastRightPoint, V::AsInt(rightGoal));
+			const F goal = V::Or(leftGoal, rightGoal);
+			const F startX = V::AndNot(goal, lastX);
+			F dirX = V::Xor(lastDirX, V::And(goal, signBit));
+
+			// ball, swept against both bars
+			const F lastY = V::Load(aLanes.ballY + i);
+			const F lastDirY = V::Load(aLanes.dirY + i);
+			F dirY = lastDirY;
+			const F motionX = V::Mul(dirX, speed);
+			const F motionY = V::Mul(dirY, speed);
+			F hit0, scalar0, time0, hit1, scalar1, time1;
+			SweepBar<V>(startX, lastY, motionX, motionY, BAR0_X, bar0Y, hit0, scalar0, time0);
+			SweepBar<V>(startX, lastY, motionX, motionY, BAR1_X, bar1Y, hit1, scalar1, time1);
+			const F scalar = V::Or(V::Or(scalar0, scalar1), V::And(hit0, hit1));
+			const F hit = V::Or(hit0, hit1);
+			const F time = Select<V>(hit0, time0, time1);
+
+			// Reflect() about the face's normal (-Sign(motionX), 0), then the
+			// rest of the step from the contact
+			const F normalX = Select<V>(V::Less(motionX, zero), V::Set(1.f), V::Set(-1.f));
+			const F dot = V::Add(V::Mul(dirX, normalX), V::Mul(dirY, zero));
+			const F bouncedDirX = V::Sub(dirX, V::Mul(V::Mul(two, dot), normalX));
+			const F bouncedDirY = V::Sub(dirY, V::Mul(V::Mul(two, dot), zero));
+			const F rest = V::Mul(V::Sub(V::Set(1.f), time), speed);
+			const F bouncedX = V::Add(V::Add(startX, V::Mul(motionX, time)), V::Mul(bouncedDirX, rest));
+			const F bouncedY = V::Add(V::Add(lastY, V::Mul(motionY, time)), V::Mul(bouncedDirY, rest));
+			const F x = Select<V>(hit, bouncedX, V::Add(startX, motionX));
+			const F y = Select<V>(hit, bouncedY, V::Add(lastY, motionY));
+			dirX = Select<V>(hit, bouncedDirX, dirX);
+			dirY = Select<V>(hit, bouncedDirY, dirY);
+
+			const F wall = V::Or(V::Greater(y, V::Set(PongWorld::WALL_Y - PongWorld::BALL_SIZE)),
+				V::Less(y, V::Set(-PongWorld::WALL_Y + PongWorld::BALL_SIZE)));
+			dirY = V::Xor(dirY, V::And(wall, signBit));
+
+			V::Store(aLanes.ballX + i, Select<V>(scalar, lastX, x));
+			V::Store(aLanes.ballY + i, Select<V>(scalar, lastY, y));
+			V::Store(aLanes.dirX + i, Select<V>(scalar, lastDirX, dirX));
+			V::Store(aLanes.dirY + i, Select<V>(scalar, lastDirY, dirY));
+			V::Store(aLanes.bar0Y + i, Select<V>(scalar, lastBar0Y, bar0Y));
+			V::Store(aLanes.bar1Y + i, Select<V>(scalar, lastBar1Y, bar1Y));
+			V::StoreInt(aLanes.leftPoint + i, V::AsInt(Select<V>(scalar, V::AsFloat(lastLeftPoint), V::AsFloat(leftPoint))));
+			V::StoreInt(aLanes.rightPoint + i, V::AsInt(Select<V>(scalar, V::AsFloat(lastRightPoint), V::AsFloat(rightPoint))));
+
+			const int scalarMask = V::MoveMask(scalar);
+			if (scalarMask != 0)
+			{
+				for (int lane = 0; lane < V::WIDTH; lane++)
+				{
+					if (scalarMask & (1 << lane))
+					{
+						aScalarMatches.push_back(i + lane);
+					}
+				}
+			}
+		}
+		return i;
+	}
+#endif
+}
+
+
+
+PongBatch::PongBatch()
+	: mCount(0)
+	, mTick(0)
+{
+}
+
+
+PongBatch::~PongBatch()
+{
+}
+
+void PongBatch::SetUp(int aCount, float aBallDeg)
+{
+	mCount = aCount;
+	mTick = 0;
+	for (auto* lane : { &mBallX, &mBallY, &mDirX, &mDirY, &mBar0Y, &mBar1Y })
+	{
+		lane->assign(aCount, 0.f);
+	}
+	mLeftPoint.assign(aCount, 0);
+	mRightPoint.assign(aCount, 0);
+
+	for (int i = 0; i < aCount; i++)
+	{
+		Reset(i, aBallDeg);
+	}
+}
+
+void PongBatch::Reset(int aIndex, float aBallDeg)
+{
+	// the serve is PongWorld's
+	mWorld.SetUp(aBallDeg);
+	mBallX[aIndex] = mWorld.GetBallPos().x;
+	mBallY[aIndex] = mWorld.GetBallPos().y;
+	mDirX[aIndex] = mWorld.GetBallDir().x;
+	mDirY[aIndex] = mWorld.GetBallDir().y;
+	mBar0Y[aIndex] = mWorld.GetBar0Pos().y;
+	mBar1Y[aIndex] = mWorld.GetBar1Pos().y;
+	mLeftPoint[aIndex] = mWorld.GetLeftPoint();
+	mRightPoint[aIndex] = mWorld.GetRightPoint();
+}
+
+void PongBatch::Step(const InputFrame* aInputs)
+{
+	mScalarMatches.clear();
+	int i = 0;
+	i = StepAvx2(aInputs, i, mCount);
+	i = StepSse2(aInputs, i, mCount);
+	StepScalar(aInputs, i, mCount);
+	// the few bounces off a bar's end or corner are PongWorld's
+	for (int match : mScalarMatches)
+	{
+		StepScalar(aInputs, match, match + 1);
+	}
+	mTick++;
+}
+
+void PongBatch::StepReference(const InputFrame* aInputs)
+{
+	StepScalar(aInputs, 0, mCount);
+	mTick++;
+}
+
+void PongBatch::StepScalar(const InputFrame* aInputs, int aBegin, int aEnd)
+{
+	for (int i = aBegin; i < aEnd; i++)
+	{
+		// one PongWorld set up once, so the rules stay in one place
+		mWorld.SetState(GetBallPos(i), GetBallDir(i), mBar0Y[i], mBar1Y[i], mLeftPoint[i], mRightPoint[i]);
+		mWorld.Step(aInputs[i]);
+		mBallX[i] = mWorld.GetBallPos().x;
+		mBallY[i] = mWorld.GetBallPos().y;
+		mDirX[i] = mWorld.GetBallDir().x;
+		mDirY[i] = mWorld.GetBallDir().y;
+		mBar0Y[i] = mWorld.GetBar0Pos().y;
+		mBar1Y[i] = mWorld.GetBar1Pos().y;
+		mLeftPoint[i] = mWorld.GetLeftPoint();
+		mRightPoint[i] = mWorld.GetRightPoint();
+	}
+}
+
+int PongBatch::StepSse2(const InputFrame* aInputs, int aBegin, int aEnd)
+{
+#ifdef PONG_BATCH_SSE2
+	const Lanes lanes = { mBallX.data(), mBallY.data(), mDirX.data(), mDirY.data(),
+		mBar0Y.data(), mBar1Y.data(), mLeftPoint.data(), mRightPoint.data() };
+	return StepLanes<Sse2>(lanes, aInputs, aBegin, aEnd, mScalarMatches);
+#else
+	(void)aInputs;
+	(void)aEnd;
+	return aBegin;
+#endif
+}
+
+int PongBatch::StepAvx2(const InputFrame* aInputs, int aBegin, int aEnd)
+{
+#ifdef PONG_BATCH_AVX2
+	const Lanes lanes = { mBallX.data(), mBallY.data(), mDirX.data(), mDirY.data(),
+		mBar0Y.data(), mBar1Y.data(), mLeftPoint.data(), mRightPoint.data() };
+	return StepLanes<Avx2>(lanes, aInputs, aBegin, aEnd, mScalarMatches);
+#else
+	(void)aInputs;
+	(void)aEnd;
+	return aBegin;
+#endif
+}
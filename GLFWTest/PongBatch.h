@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "PongWorld.h"
+
+// Many independent Pong matches stepped in lockstep. The state is kept
+// as one array per field (structure of arrays) and Step() advances 8
+// matches per instruction with AVX2 or 4 with SSE2, whichever the build
+// targets, and the remainder one by one. The matches run at
+// PongWorld::STEP_HZ.
+//
+// The sweep of the ball against the bars runs in the vector kernels too,
+// for hits on a bar's face; the rare bounce off a bar's end or corner is
+// left to PongWorld, one match at a time. The rules are PongWorld's,
+// operation for operation, so every match comes out bit for bit the same
+// as a PongWorld fed the same inputs, as long as the compiler does not
+// fuse the scalar multiply-adds (FMA contraction, e.g. GCC's
+// -ffp-contract=fast with -mfma).
+class PongBatch
+{
+public:
+	PongBatch();
+	~PongBatch();
+	// aCount matches, all served like PongWorld::SetUp(aBallDeg)
+	void SetUp(int aCount, float aBallDeg = PongWorld::BALL_DEG);
+	// starts match aIndex over, the others keep going
+	void Reset(int aIndex, float aBallDeg = PongWorld::BALL_DEG);
+
+	// aInputs holds one InputFrame per match
+	void Step(const InputFrame* aInputs);
+	// the same step without SIMD, to verify Step() against
+	void StepReference(const InputFrame* aInputs);
+
+	int GetCount() const { return mCount; }
+	// steps since SetUp(), for all matches
+	unsigned int GetTick() const { return mTick; }
+	Vec2 GetBallPos(int aIndex) const { return { mBallX[aIndex], mBallY[aIndex] }; }
+	Vec2 GetBallDir(int aIndex) const { return { mDirX[aIndex], mDirY[aIndex] }; }
+	Vec2 GetBar0Pos(int aIndex) const { return { -PongWorld::BAR_X, mBar0Y[aIndex] }; }
+	Vec2 GetBar1Pos(int aIndex) const { return { +PongWorld::BAR_X, mBar1Y[aIndex] }; }
+	int GetLeftPoint(int aIndex) const { return mLeftPoint[aIndex]; }
+	int GetRightPoint(int aIndex) const { return mRightPoint[aIndex]; }
+
+private:
+	void StepScalar(const InputFrame* aInputs, int aBegin, int aEnd);
+	int StepSse2(const InputFrame* aInputs, int aBegin, int aEnd);
+	int StepAvx2(const InputFrame* aInputs, int aBegin, int aEnd);
+
+	int mCount;
+	unsigned int mTick;
+	std::vector<float> mBallX;
+	std::vector<float> mBallY;
+	std::vector<float> mDirX;
+	std::vector<float> mDirY;
+	// the bars only move vertically, x is always -+BAR_X
+	std::vector<float> mBar0Y;
+	std::vector<float> mBar1Y;
+	std::vector<int> mLeftPoint;
+	std::vector<int> mRightPoint;
+	// matches the vector kernels left for StepScalar() in this Step()
+	std::vector<int> mScalarMatches;
+	// steps those matches, and serves
+	PongWorld mWorld;
+};
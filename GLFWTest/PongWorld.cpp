@@ -0,0 +1,142 @@
+#include <cmath>
+#include <initializer_list>
+
+#include "Collision.h"
+#include "PongWorld.h"
+
+
+
+namespace
+{
+	constexpr float PI = 3.14159265358f;
+}
+
+
+
+PongWorld::PongWorld()
+{
+	SetUp();
+}
+
+
+PongWorld::~PongWorld()
+{
+}
+
+void PongWorld::SetUp(float aBallDeg, int aStepHz)
+{
+	// exactly 1 at STEP_HZ, which keeps 60 Hz matches bit for bit as before
+	const float scale = static_cast<float>(STEP_HZ) / aStepHz;
+	mBallSpeed = BALL_SPEED * scale;
+	mBarSpeed = BAR_SPEED * scale;
+	// double precision sin like the original, so matches replay bit for bit
+	const double rad = aBallDeg / 180.0f * PI;
+	mBallPos = { 0.f, 0.f };
+	mBallDir = { static_cast<float>(std::sin(rad)), static_cast<float>(std::cos(rad)) };
+	mBar0Pos = { -BAR_X, 0.f };
+	mBar1Pos = { +BAR_X, 0.f };
+	mLeftPoint = 0;
+	mRightPoint = 0;
+	mTick = 0;
+}
+
+void PongWorld::SetState(const Vec2& aBallPos, const Vec2& aBallDir, float aBar0Y, float aBar1Y, int aLeftPoint, int aRightPoint)
+{
+	mBallPos = aBallPos;
+	mBallDir = aBallDir;
+	mBar0Pos.y = aBar0Y;
+	mBar1Pos.y = aBar1Y;
+	mLeftPoint = aLeftPoint;
+	mRightPoint = aRightPoint;
+}
+
+void PongWorld::Step(const InputFrame& aInput)
+{
+	// bars
+	if (aInput.buttons & BUTTON_LEFT_UP)
+	{
+		MoveBar(mBar0Pos, +mBarSpeed);
+	}
+	else if (aInput.buttons & BUTTON_LEFT_DOWN)
+	{
+		MoveBar(mBar0Pos, -mBarSpeed);
+	}
+
+	if (aInput.buttons & BUTTON_RIGHT_UP)
+	{
+		MoveBar(mBar1Pos, +mBarSpeed);
+	}
+	else if (aInput.buttons & BUTTON_RIGHT_DOWN)
+	{
+		MoveBar(mBar1Pos, -mBarSpeed);
+	}
+
+	// goal: score, then serve from the middle towards the other side
+	if (mBallPos.x > +GOAL_X)
+	{
+		mLeftPoint++;
+		mBallPos.x = 0;
+		mBallDir.x *= -1;
+	}
+	else if (mBallPos.x < -GOAL_X)
+	{
+		mRightPoint++;
+		mBallPos.x = 0;
+		mBallDir.x *= -1;
+	}
+
+	// ball: the whole move is swept against the bars, so a fast ball or a
+	// long step cannot pass through one
+	const Vec2 motion = { mBallDir.x * mBallSpeed, mBallDir.y * mBallSpeed };
+	SweepHit hit;
+	bool hasHit = false;
+	for (const Vec2* bar : { &mBar0Pos, &mBar1Pos })
+	{
+		SweepHit barHit;
+		if (SweepCircleBox(mBallPos, motion, BALL_HIT_HALF, *bar, { BAR_HIT_HALF_X, BAR_HIT_HALF_Y }, barHit)
+			&& (!hasHit || barHit.time < hit.time))
+		{
+			hit = barHit;
+			hasHit = true;
+		}
+	}
+	if (hasHit)
+	{
+		// bounce at the contact and spend the rest of the step in the new direction
+		mBallDir = Reflect(mBallDir, hit.normal);
+		const float rest = (1 - hit.time) * mBallSpeed;
+		mBallPos.x = hit.position.x + mBallDir.x * rest;
+		mBallPos.y = hit.position.y + mBallDir.y * rest;
+	}
+	else
+	{
+		mBallPos.x += motion.x;
+		mBallPos.y += motion.y;
+	}
+
+	// top and bottom walls
+	if (mBallPos.y > WALL_Y - BALL_SIZE)
+	{
+		mBallDir.y *= -1;
+	}
+	else if (mBallPos.y < -WALL_Y + BALL_SIZE)
+	{
+		mBallDir.y *= -1;
+	}
+
+	mTick++;
+}
+
+void PongWorld::MoveBar(Vec2& aPos, float aDelta)
+{
+	const float limit = BAR_Y_LIMIT - BAR_HEIGHT / 2;
+	aPos.y += aDelta;
+	if (aPos.y > limit)
+	{
+		aPos.y = limit;
+	}
+	if (aPos.y < -limit)
+	{
+		aPos.y = -limit;
+	}
+}
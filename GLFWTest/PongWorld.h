@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Vec2.h"
+
+// buttons of both players, sampled once per step
+enum InputButton
+{
+	BUTTON_LEFT_UP    = 1 << 0,
+	BUTTON_LEFT_DOWN  = 1 << 1,
+	BUTTON_RIGHT_UP   = 1 << 2,
+	BUTTON_RIGHT_DOWN = 1 << 3,
+};
+
+// everything a step needs from the outside
+struct InputFrame
+{
+	unsigned int buttons; // InputButton bits
+};
+
+// One Pong match: the ball, both bars and the score. Step() only reads
+// its input and the state here, no GLFW, GL or clock, so the same inputs
+// always give the same match and many matches can run side by side
+// without a window.
+//
+// Units are the game's view coordinates. The ball's quad spans
+// +-BALL_SIZE and it bounces off the walls at that distance, but against
+// the bars it is a circle of only BALL_SIZE / 2, like the game always
+// did. It is swept against the bars over the whole step, so it bounces at
+// the exact contact point however fast it moves.
+class PongWorld
+{
+public:
+	// the speeds are per step at this rate
+	static constexpr int STEP_HZ = 60;
+	static constexpr float BALL_SIZE = 0.15f;
+	static constexpr float BALL_SPEED = 0.01f; // per step
+	static constexpr float BALL_DEG = 50.f;    // start direction, 0 is up
+	static constexpr float BAR_WIDTH = 0.1f;
+	static constexpr float BAR_HEIGHT = 0.5f;
+	static constexpr float BAR_X = 0.5f;       // bar0 at -BAR_X, bar1 at +BAR_X
+	static constexpr float BAR_SPEED = 0.015f; // per step
+	static constexpr float BAR_Y_LIMIT = 0.625f;
+	static constexpr float WALL_Y = 0.55f;
+	static constexpr float GOAL_X = 0.8f;
+	// the collision shapes are half the size of the sprites
+	static constexpr float BALL_HIT_HALF = BALL_SIZE / 2;
+	static constexpr float BAR_HIT_HALF_X = BAR_WIDTH / 4;
+	static constexpr float BAR_HIT_HALF_Y = BAR_HEIGHT / 4;
+
+	PongWorld();
+	~PongWorld();
+	// puts the ball in the middle and clears the score. At an aStepHz
+	// other than STEP_HZ the speeds are scaled to keep the game's pace.
+	void SetUp(float aBallDeg = BALL_DEG, int aStepHz = STEP_HZ);
+	// continues a match from the given state, e.g. one of a PongBatch
+	void SetState(const Vec2& aBallPos, const Vec2& aBallDir, float aBar0Y, float aBar1Y, int aLeftPoint, int aRightPoint);
+
+	// advances the match by one step, 1 / aStepHz s
+	void Step(const InputFrame& aInput);
+
+	const Vec2& GetBallPos() const { return mBallPos; }
+	const Vec2& GetBallDir() const { return mBallDir; }
+	const Vec2& GetBar0Pos() const { return mBar0Pos; }
+	const Vec2& GetBar1Pos() const { return mBar1Pos; }
+	int GetLeftPoint() const { return mLeftPoint; }
+	int GetRightPoint() const { return mRightPoint; }
+	unsigned int GetTick() const { return mTick; }
+
+private:
+	static void MoveBar(Vec2& aPos, float aDelta);
+
+	float mBallSpeed;
+	float mBarSpeed;
+	Vec2 mBallPos;
+	Vec2 mBallDir;
+	Vec2 mBar0Pos;
+	Vec2 mBar1Pos;
+	int mLeftPoint;
+	int mRightPoint;
+	unsigned int mTick;
+};
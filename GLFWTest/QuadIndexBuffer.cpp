@@ -0,0 +1,58 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "QuadIndexBuffer.h"
+
+
+
+QuadIndexBuffer& QuadIndexBuffer::Get()
+{
+	static QuadIndexBuffer sInstance;
+	return sInstance;
+}
+
+QuadIndexBuffer::QuadIndexBuffer()
+	: mCapacity(0)
+{
+}
+
+void QuadIndexBuffer::Reserve(int aQuadCount)
+{
+	aQuadCount = std::min(aQuadCount, QUAD_MAX);
+	if (aQuadCount <= mCapacity)
+	{
+		return;
+	}
+
+	static const uint16_t PATTERN[INDICES_PER_QUAD] = { 0, 1, 2, 0, 2, 3 };
+	std::vector<uint16_t> indices(aQuadCount * INDICES_PER_QUAD);
+	for (int quad = 0; quad < aQuadCount; quad++)
+	{
+		for (int i = 0; i < INDICES_PER_QUAD; i++)
+		{
+			indices[quad * INDICES_PER_QUAD + i] = static_cast<uint16_t>(quad * 4 + PATTERN[i]);
+		}
+	}
+	// same buffer id, so vertex arrays that already reference it stay valid
+	mBuffer.SetUp(GL_ELEMENT_ARRAY_BUFFER, indices.data(), indices.size() * sizeof(uint16_t));
+	mCapacity = aQuadCount;
+}
+
+void QuadIndexBuffer::Bind() const
+{
+	mBuffer.Bind();
+}
+
+void QuadIndexBuffer::Draw(int aQuadCount) const
+{
+	if (aQuadCount > mCapacity)
+	{
+		std::cerr << "QuadIndexBuffer: " << aQuadCount << " quads drawn, only " << mCapacity << " reserved\n";
+		aQuadCount = mCapacity;
+	}
+	glDrawElements(GL_TRIANGLES, aQuadCount * INDICES_PER_QUAD, GL_UNSIGNED_SHORT, nullptr);
+}
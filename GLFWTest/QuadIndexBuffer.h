@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "StaticBuffer.h"
+
+// Shared GL_ELEMENT_ARRAY_BUFFER holding 0,1,2, 0,2,3 for every quad of
+// four vertices, the order a GL_TRIANGLE_FAN quad is stored in. Drawing
+// GL_TRIANGLES through it lets any number of quads, from any object,
+// go out in one glDrawElements call.
+class QuadIndexBuffer
+{
+public:
+	static constexpr int INDICES_PER_QUAD = 6;
+	// uint16 indices reach 65536 vertices
+	static constexpr int QUAD_MAX = 65536 / 4;
+
+	static QuadIndexBuffer& Get();
+
+	// grows the buffer to hold at least aQuadCount quads, at most QUAD_MAX
+	void Reserve(int aQuadCount);
+	// element buffer bindings are vertex array state: bind after the vertex array
+	void Bind() const;
+	// quads starting at the first vertex of the bound attribute pointers
+	void Draw(int aQuadCount) const;
+
+	int GetCapacity() const { return mCapacity; }
+
+private:
+	QuadIndexBuffer();
+
+	StaticBuffer mBuffer;
+	int mCapacity;
+};
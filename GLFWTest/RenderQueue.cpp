@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cassert>
+
+#include "RenderQueue.h"
+
+
+
+RenderQueue::RenderQueue()
+{
+}
+
+
+RenderQueue::~RenderQueue()
+{
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int aLayer, unsigned int aProgram, unsigned int aTexture, unsigned int aMesh, float aDepth)
+{
+	const uint64_t depthMax = (uint64_t(1) << DEPTH_BITS) - 1;
+	const uint64_t depth = static_cast<uint64_t>(std::min(std::max(aDepth, 0.f), 1.f) * depthMax);
+
+	// a value cut to its field would share a key with a different one
+	assert(aLayer < (1u << LAYER_BITS) && "layer does not fit the key");
+	assert(aProgram < (1u << PROGRAM_BITS) && "program does not fit the key");
+	assert(aTexture < (1u << TEXTURE_BITS) && "texture does not fit the key");
+	assert(aMesh < (1u << MESH_BITS) && "mesh does not fit the key");
+
+	uint64_t key = aLayer & ((1u << LAYER_BITS) - 1);
+	key = (key << PROGRAM_BITS) | (aProgram & ((1u << PROGRAM_BITS) - 1));
+	key = (key << TEXTURE_BITS) | (aTexture & ((1u << TEXTURE_BITS) - 1));
+	key = (key << MESH_BITS) | (aMesh & ((1u << MESH_BITS) - 1));
+	key = (key << DEPTH_BITS) | depth;
+	return key;
+}
+
+void RenderQueue::Push(uint64_t aKey, uint32_t aPayload)
+{
+	mCommands.push_back({ aKey, aPayload });
+}
+
+void RenderQueue::Clear()
+{
+	mCommands.clear();
+}
+
+void RenderQueue::Sort()
+{
+	if (mCommands.size() < 2)
+	{
+		return;
+	}
+
+	// bytes that are the same in every key don't need a pass
+	uint64_t differing = 0;
+	for (const auto& command : mCommands)
+	{
+		differing |= command.key ^ mCommands[0].key;
+	}
+
+	mScratch.resize(mCommands.size());
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		if (((differing >> shift) & 0xff) == 0)
+		{
+			continue;
+		}
+
+		size_t offsets[256] = {};
+		for (const auto& command : mCommands)
+		{
+			offsets[(command.key >> shift) & 0xff]++;
+		}
+		size_t total = 0;
+		for (auto& offset : offsets)
+		{
+			const size_t count = offset;
+			offset = total;
+			total += count;
+		}
+		for (const auto& command : mCommands)
+		{
+			mScratch[offsets[(command.key >> shift) & 0xff]++] = command;
+		}
+		mCommands.swap(mScratch);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact draw command: a sort key and the index of the payload in the
+// submitter's own storage. Pushing does not touch GL, so the list can be
+// built on any thread and handed to the thread owning the context.
+struct RenderCommand
+{
+	uint64_t key;
+	uint32_t payload;
+};
+
+// Draw commands sorted by a 64-bit key, most significant field first:
+//   layer:8 | program:8 | texture:16 | mesh:12 | depth:20
+// Sorting groups commands sharing state, so executing them in order
+// changes the program, texture and mesh as few times as possible.
+class RenderQueue
+{
+public:
+	static constexpr int DEPTH_BITS = 20;
+	static constexpr int MESH_BITS = 12;
+	static constexpr int TEXTURE_BITS = 16;
+	static constexpr int PROGRAM_BITS = 8;
+	static constexpr int LAYER_BITS = 8;
+	// key bits that select GL state, the depth is only an order
+	static constexpr uint64_t STATE_MASK = ~((uint64_t(1) << DEPTH_BITS) - 1);
+
+	RenderQueue();
+	~RenderQueue();
+
+	// aDepth in [0, 1], smaller is drawn first within the same state. The
+	// other values must fit their fields, so pass small indices rather than
+	// GL names, which can grow without bound.
+	static uint64_t MakeKey(unsigned int aLayer, unsigned int aProgram, unsigned int aTexture, unsigned int aMesh, float aDepth);
+
+	void Push(uint64_t aKey, uint32_t aPayload);
+	void Clear();
+	// stable LSD radix sort, one pass per key byte that actually varies
+	void Sort();
+
+	const std::vector<RenderCommand>& GetCommands() const { return mCommands; }
+	size_t GetCount() const { return mCommands.size(); }
+
+private:
+	std::vector<RenderCommand> mCommands;
+	std::vector<RenderCommand> mScratch;
+};
@@ -0,0 +1,79 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+#include "RenderTarget.h"
+
+
+
+RenderTarget::RenderTarget()
+	: mFramebufferId(0)
+	, mColorId(0)
+	, mDepthId(0)
+	, mWidth(0)
+	, mHeight(0)
+{
+}
+
+
+RenderTarget::~RenderTarget()
+{
+}
+
+bool RenderTarget::SetUp(int aWidth, int aHeight)
+{
+	if (!GLAD_GL_VERSION_3_0)
+	{
+		std::cerr << "RenderTarget: framebuffer objects need OpenGL 3.0\n";
+		return false;
+	}
+
+	mWidth = aWidth;
+	mHeight = aHeight;
+
+	glGenRenderbuffers(1, &mColorId);
+	glBindRenderbuffer(GL_RENDERBUFFER, mColorId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, aWidth, aHeight);
+
+	glGenRenderbuffers(1, &mDepthId);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepthId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, aWidth, aHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &mFramebufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthId);
+	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "RenderTarget: framebuffer incomplete (0x" << std::hex << status << std::dec << ")\n";
+		return false;
+	}
+	return true;
+}
+
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebufferId);
+	glViewport(0, 0, mWidth, mHeight);
+}
+
+void RenderTarget::Unbind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::ReadPixels(Image& aImage) const
+{
+	aImage.width = mWidth;
+	aImage.height = mHeight;
+	aImage.pixels.resize(mWidth * mHeight * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebufferId);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, mWidth, mHeight, GL_BGR, GL_UNSIGNED_BYTE, aImage.pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "Image.h"
+
+// Offscreen framebuffer with an RGBA8 color and a depth renderbuffer.
+class RenderTarget
+{
+public:
+	RenderTarget();
+	~RenderTarget();
+	bool SetUp(int aWidth, int aHeight);
+
+	void Bind() const;
+	void Unbind() const;
+	// reads the color buffer into aImage (BGR, bottom row first)
+	void ReadPixels(Image& aImage) const;
+
+	int GetWidth() const { return mWidth; }
+	int GetHeight() const { return mHeight; }
+
+private:
+	GLuint mFramebufferId;
+	GLuint mColorId;
+	GLuint mDepthId;
+	int mWidth;
+	int mHeight;
+};
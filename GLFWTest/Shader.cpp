@@ -1,12 +1,40 @@
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
+#include <iostream>
 #include <string>
 
+#include "FileWatcher.h"
+#include "GLStateCache.h"
 #include "Shader.h"
 
 
 
-Shader::Shader()
+const VertexLayout& Shader::GetVertexLayout()
+{
+	// 8 bytes instead of 16; local positions stay within -1..1, the transform scales them
+	static const VertexLayout layout = VertexLayout()
+		.Add("position", POSITION_LOCATION, 2, GL_SHORT, true)
+		.Add("uv", UV_LOCATION, 2, GL_UNSIGNED_SHORT, true);
+	return layout;
+}
+
+const VertexLayout& Shader::GetInstanceLayout()
+{
+	// 32 bytes instead of 52; uv rects and tints are within 0..1
+	static const VertexLayout layout = VertexLayout()
+		.Add("transform", TRANSFORM_LOCATION, 4, GL_FLOAT, false)
+		.Add("uvRect", UV_RECT_LOCATION, 4, GL_UNSIGNED_SHORT, true)
+		.Add("tint", TINT_LOCATION, 4, GL_UNSIGNED_BYTE, true)
+		.Add("rotation", ROTATION_LOCATION, 1, GL_FLOAT, false);
+	return layout;
+}
+
+Shader::Shader(ShaderType aType)
+	: mType(aType)
+	, mProgramId(0)
+	, mPendingProgramId(0)
+	, mFallback(nullptr)
+	, mSourceVersion(0)
 {
 }
 
@@ -15,49 +43,109 @@ Shader::~Shader()
 {
 }
 
-void Shader::SetUp()
+bool Shader::SetUp(const Shader* aFallback)
 {
 	//static const int VERTEX_BUFFER_COUNT = 4;
 	//GLuint vertexBuffers[VERTEX_BUFFER_COUNT];
 	//glGenBuffers(VERTEX_BUFFER_COUNT, vertexBuffers);
-	//o[ebNXVF[_̃RpC
-	auto vShaderId = glCreateShader(GL_VERTEX_SHADER);
-	std::string vertexShader = R"#(
-	uniform mat4 MVP;
-	attribute vec3 position;
-	attribute vec2 uv;
-	varying vec2 vuv;
-	void main(void){
-		gl_Position = MVP * vec4(position, 1.0);
-		vuv = uv;
+	mFallback = aFallback;
+	FileWatcher::Get().Watch(VERTEX_SHADER_PATH);
+	FileWatcher::Get().Watch(FRAGMENT_SHADER_PATH);
+	mSourceVersion = GetSourceVersion();
+	if (!Load())
+	{
+		return false;
 	}
-	)#";
-	const char* vs = vertexShader.c_str();
-	glShaderSource(vShaderId, 1, &vs, NULL);
-	glCompileShader(vShaderId);
-
-	//tOgVF[_̃RpC
-	GLuint fShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-	std::string fragmentShader = R"#(
-	varying vec2 vuv;
-	uniform sampler2D texture;
-	void main(void){
-		gl_FragColor = texture2D(texture, vuv);
+	if (mFallback == nullptr)
+	{
+		// nothing else to draw with
+		Swap(ShaderManager::Get().Wait(mPendingProgramId));
+		return IsReady();
 	}
-	)#";
-	const char* fs = fragmentShader.c_str();
-	glShaderSource(fShaderId, 1, &fs, NULL);
-	glCompileShader(fShaderId);
+	return true;
+}
 
-	//vOIuWFNg̍쐬
-	GLuint programId = glCreateProgram();
-	glAttachShader(programId, vShaderId);
-	glAttachShader(programId, fShaderId);
+void Shader::Update()
+{
+	const unsigned version = GetSourceVersion();
+	if (version != mSourceVersion)
+	{
+		mSourceVersion = version;
+		std::cout << "reloading " << VERTEX_SHADER_PATH << " and " << FRAGMENT_SHADER_PATH << "\n";
+		Load();
+	}
+	if (mPendingProgramId != 0)
+	{
+		Swap(ShaderManager::Get().GetStatus(mPendingProgramId));
+	}
+}
 
-	// N
-	glLinkProgram(programId);
+// versions only grow, so their sum changes whenever either file does
+unsigned Shader::GetSourceVersion() const
+{
+	return FileWatcher::Get().GetVersion(VERTEX_SHADER_PATH) + FileWatcher::Get().GetVersion(FRAGMENT_SHADER_PATH);
+}
 
-	glUseProgram(programId);
+bool Shader::Load()
+{
+	// ނƂ̈ႢdefineŐ؂ւ
+	std::string defines;
+	if (mType == SHADER_CIRCLE || mType == SHADER_RAINBOW_CIRCLE)
+	{
+		defines += "#define CIRCLE\n";
+	}
+	if (mType == SHADER_RAINBOW_CIRCLE)
+	{
+		defines += "#define RAINBOW\n";
+	}
+
+	// \[X̓t@Cǂ
+	std::string vertexShader, fragmentShader;
+	if (!ShaderManager::ReadSource(VERTEX_SHADER_PATH, vertexShader) || !ShaderManager::ReadSource(FRAGMENT_SHADER_PATH, fragmentShader))
+	{
+		return false;
+	}
+	vertexShader = defines + vertexShader;
+	fragmentShader = defines + fragmentShader;
+
+	// RpCƃNJn (LbVɂΓǂݍނ)
+	// attribute 0 must be a per-vertex array in compatibility profiles.
+	// fixed locations let a batch switch programs without re-pointing attributes
+	static const char* const NAMES[] = { "sprite", "circle", "rainbow circle" };
+	if (mPendingProgramId != 0)
+	{
+		// the sources changed again before the last build finished
+		ShaderManager::Get().Cancel(mPendingProgramId);
+	}
+	mPendingProgramId = ShaderManager::Get().BeginProgram(NAMES[mType], vertexShader, fragmentShader,
+		{ &GetVertexLayout(), &GetInstanceLayout() });
+	return true;
+}
+
+void Shader::Swap(ProgramStatus aStatus)
+{
+	if (aStatus == PROGRAM_PENDING)
+	{
+		return;
+	}
+	const GLuint programId = mPendingProgramId;
+	mPendingProgramId = 0;
+	if (aStatus == PROGRAM_FAILED)
+	{
+		if (mProgramId != 0)
+		{
+			std::cerr << "Shader: keeping the previous program\n";
+		}
+		return;
+	}
+	if (mProgramId != 0)
+	{
+		// the driver may hand the old name out again, forget its cached uniforms
+		glDeleteProgram(mProgramId);
+		GLStateCache::Get().Invalidate();
+	}
+
+	GLStateCache::Get().UseProgram(programId);
 
 	mProgramId = programId;
 	// Ԗڂattributeϐ
@@ -65,13 +153,11 @@ void Shader::SetUp()
 	mUvLocation       = glGetAttribLocation(programId, "uv");
 	mTextureLocation  = glGetUniformLocation(programId, "texture");
 	mMvpLocation      = glGetUniformLocation(programId, "MVP");
-
-	// attributeLɂ
-	glEnableVertexAttribArray(mPositionLocation);
-	glEnableVertexAttribArray(mUvLocation);
-	glEnableVertexAttribArray(mMvpLocation);
+	mTransformLocation = glGetAttribLocation(programId, "transform");
+	mUvRectLocation   = glGetAttribLocation(programId, "uvRect");
+	mTintLocation     = glGetAttribLocation(programId, "tint");
+	mRotationLocation = glGetAttribLocation(programId, "rotation");
 
 	// uniformݒ肷
-	glUniform1i(mTextureLocation, 0);
-
+	GLStateCache::Get().Uniform1i(mTextureLocation, 0);
 }
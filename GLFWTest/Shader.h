@@ -1,18 +1,71 @@
 #pragma once
 
+#include "ShaderManager.h"
+#include "VertexLayout.h"
+
+enum ShaderType
+{
+	SHADER_SPRITE,
+	// draws the mesh uv square as an anti-aliased disc (signed distance field)
+	SHADER_CIRCLE,
+	// SHADER_CIRCLE filled with a rainbow gradient instead of the texture
+	SHADER_RAINBOW_CIRCLE,
+};
+
 class Shader
 {
 public:
-	Shader();
+	// every type shares the sprite attributes and their locations
+	static constexpr int POSITION_LOCATION = 0;
+	static constexpr int UV_LOCATION = 1;
+	static constexpr int TRANSFORM_LOCATION = 2;
+	static constexpr int UV_RECT_LOCATION = 3;
+	static constexpr int TINT_LOCATION = 4;
+	static constexpr int ROTATION_LOCATION = 5;
+
+	// per-vertex attributes of Mesh and per-instance attributes of SpriteBatch
+	static const VertexLayout& GetVertexLayout();
+	static const VertexLayout& GetInstanceLayout();
+
+	Shader(ShaderType aType = SHADER_SPRITE);
 	~Shader();
-	void SetUp();
+	// sources are read from these files, relative to the working directory
+	static constexpr const char* VERTEX_SHADER_PATH = "VertexShader.vs";
+	static constexpr const char* FRAGMENT_SHADER_PATH = "FragmentShader.fs";
+
+	// Without aFallback the program is built before returning, false if it
+	// fails. With one, SetUp() only starts the build and GetActive() gives
+	// the fallback until Update() sees the program linked.
+	bool SetUp(const Shader* aFallback = nullptr);
+	// call between frames: swaps in a finished build, and rebuilds the
+	// program once FileWatcher saw the sources change. A build that fails
+	// keeps the previous program.
+	void Update();
+	// the shader to draw with: this one, or the fallback while it is not built yet
+	const Shader& GetActive() const { return mProgramId == 0 && mFallback != nullptr ? mFallback->GetActive() : *this; }
+	bool IsReady() const { return mProgramId != 0; }
+	GLuint GetProgramId() const { return mProgramId; }
+	ShaderType GetType() const { return mType; }
 
 	int mPositionLocation;
 	int mUvLocation;
 	int mTextureLocation;
 	int mMvpLocation;
+	int mTransformLocation;
+	int mUvRectLocation;
+	int mTintLocation;
+	int mRotationLocation;
 
 private:
+	unsigned GetSourceVersion() const;
+	// starts building from the source files
+	bool Load();
+	void Swap(ProgramStatus aStatus);
+
+	ShaderType mType;
 	GLuint mProgramId;
+	GLuint mPendingProgramId;
+	const Shader* mFallback;
+	unsigned mSourceVersion;
 };
 
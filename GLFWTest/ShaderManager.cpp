@@ -0,0 +1,367 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "ShaderManager.h"
+#include "VertexLayout.h"
+
+// GL_KHR_parallel_shader_compile, not in the generated glad
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define MakeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MakeDirectory(path) mkdir(path, 0755)
+#endif
+
+
+
+namespace
+{
+	const uint32_t BINARY_MAGIC = 0x42505347; // "GSPB"
+
+	// FNV-1a, the terminator is hashed too so that "ab" + "c" != "a" + "bc"
+	uint64_t Hash(uint64_t aHash, const std::string& aText)
+	{
+		for (size_t i = 0; i <= aText.size(); i++)
+		{
+			aHash ^= static_cast<unsigned char>(aText.c_str()[i]);
+			aHash *= 1099511628211ull;
+		}
+		return aHash;
+	}
+
+	std::string GetString(GLenum aName)
+	{
+		const GLubyte* value = glGetString(aName);
+		return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+	}
+
+	// glad only knows the extensions it was generated with
+	bool HasExtension(const char* aName)
+	{
+		if (GLAD_GL_VERSION_3_0)
+		{
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; i++)
+			{
+				const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+				if (extension != nullptr && std::strcmp(reinterpret_cast<const char*>(extension), aName) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		// one space separated list before 3.0
+		const std::string extensions = " " + GetString(GL_EXTENSIONS) + " ";
+		return extensions.find(" " + std::string(aName) + " ") != std::string::npos;
+	}
+}
+
+
+
+ShaderManager& ShaderManager::Get()
+{
+	static ShaderManager sInstance;
+	return sInstance;
+}
+
+ShaderManager::ShaderManager()
+	: mLoadedCount(0)
+	, mCompiledCount(0)
+	, mBinaryCache(false)
+	, mParallelCompile(false)
+	, mFinishBudget(1)
+{
+}
+
+void ShaderManager::SetUp(const std::string& aCacheDirectory)
+{
+	mCacheDirectory = aCacheDirectory;
+	mDriver = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" + GetString(GL_VERSION);
+
+	// glGetProgramBinary is core since 4.1; drivers may still offer no format
+	GLint formatCount = 0;
+	if (GLAD_GL_VERSION_4_1)
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	}
+	mBinaryCache = !mCacheDirectory.empty() && formatCount > 0;
+	if (mBinaryCache)
+	{
+		// fails harmlessly when the directory exists
+		MakeDirectory(mCacheDirectory.c_str());
+	}
+
+	// the ARB version is the same extension under another name
+	mParallelCompile = HasExtension("GL_KHR_parallel_shader_compile") || HasExtension("GL_ARB_parallel_shader_compile");
+}
+
+void ShaderManager::Update()
+{
+	mFinishBudget = 1;
+}
+
+GLuint ShaderManager::BeginProgram(const char* aName, const std::string& aVertexSource, const std::string& aFragmentSource,
+	std::initializer_list<const VertexLayout*> aLayouts)
+{
+	uint64_t hash = 14695981039346656037ull;
+	std::string path;
+	if (mBinaryCache)
+	{
+		hash = Hash(hash, mDriver);
+		hash = Hash(hash, aVertexSource);
+		hash = Hash(hash, aFragmentSource);
+		for (const VertexLayout* layout : aLayouts)
+		{
+			for (const auto& attribute : layout->GetAttributes())
+			{
+				hash = Hash(hash, attribute.name + std::string("@") + std::to_string(attribute.location));
+			}
+		}
+
+		char fileName[32];
+		std::snprintf(fileName, sizeof(fileName), "/%016llx.bin", static_cast<unsigned long long>(hash));
+		path = mCacheDirectory + fileName;
+
+		// loading a binary is quick, it is ready right away
+		const GLuint programId = LoadBinary(path, hash);
+		if (programId != 0)
+		{
+			mLoadedCount++;
+			return programId;
+		}
+	}
+
+	// nothing here waits: the status is read in Finish()
+	Pending pending;
+	pending.vertexShaderId = Compile(GL_VERTEX_SHADER, aVertexSource);
+	pending.fragmentShaderId = Compile(GL_FRAGMENT_SHADER, aFragmentSource);
+	pending.programId = glCreateProgram();
+	pending.name = aName;
+	pending.cachePath = path;
+	pending.hash = hash;
+	glAttachShader(pending.programId, pending.vertexShaderId);
+	glAttachShader(pending.programId, pending.fragmentShaderId);
+	for (const VertexLayout* layout : aLayouts)
+	{
+		layout->BindLocations(pending.programId);
+	}
+	if (mBinaryCache)
+	{
+		glProgramParameteri(pending.programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(pending.programId);
+	mPending.push_back(pending);
+	return pending.programId;
+}
+
+ProgramStatus ShaderManager::GetStatus(GLuint aProgramId)
+{
+	for (size_t i = 0; i < mPending.size(); i++)
+	{
+		if (mPending[i].programId != aProgramId)
+		{
+			continue;
+		}
+		if (mParallelCompile)
+		{
+			GLint completed = GL_FALSE;
+			glGetProgramiv(aProgramId, GL_COMPLETION_STATUS_KHR, &completed);
+			if (completed != GL_TRUE)
+			{
+				return PROGRAM_PENDING;
+			}
+		}
+		else if (mFinishBudget <= 0)
+		{
+			return PROGRAM_PENDING;
+		}
+		else
+		{
+			mFinishBudget--;
+		}
+		return Finish(i);
+	}
+	return PROGRAM_READY;
+}
+
+ProgramStatus ShaderManager::Wait(GLuint aProgramId)
+{
+	for (size_t i = 0; i < mPending.size(); i++)
+	{
+		if (mPending[i].programId == aProgramId)
+		{
+			return Finish(i);
+		}
+	}
+	return PROGRAM_READY;
+}
+
+void ShaderManager::Cancel(GLuint aProgramId)
+{
+	for (size_t i = 0; i < mPending.size(); i++)
+	{
+		if (mPending[i].programId == aProgramId)
+		{
+			glDeleteShader(mPending[i].vertexShaderId);
+			glDeleteShader(mPending[i].fragmentShaderId);
+			glDeleteProgram(aProgramId);
+			mPending.erase(mPending.begin() + i);
+			return;
+		}
+	}
+}
+
+GLuint ShaderManager::CreateProgram(const char* aName, const std::string& aVertexSource, const std::string& aFragmentSource,
+	std::initializer_list<const VertexLayout*> aLayouts)
+{
+	const GLuint programId = BeginProgram(aName, aVertexSource, aFragmentSource, aLayouts);
+	return Wait(programId) == PROGRAM_READY ? programId : 0;
+}
+
+bool ShaderManager::ReadSource(const std::string& aPath, std::string& aSource)
+{
+	std::ifstream file(aPath, std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "ShaderManager: could not open " << aPath << "\n";
+		return false;
+	}
+	aSource.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+GLuint ShaderManager::Compile(GLenum aType, const std::string& aSource) const
+{
+	const GLuint shaderId = glCreateShader(aType);
+	const char* source = aSource.c_str();
+	glShaderSource(shaderId, 1, &source, nullptr);
+	glCompileShader(shaderId);
+	return shaderId;
+}
+
+// reads the link status, blocking if the driver is not done yet
+ProgramStatus ShaderManager::Finish(size_t aPending)
+{
+	const Pending pending = mPending[aPending];
+	mPending.erase(mPending.begin() + aPending);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(pending.programId, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		// a failed compile fails the link too, its log is the useful one
+		PrintShaderLog(pending, pending.vertexShaderId, "vertex");
+		PrintShaderLog(pending, pending.fragmentShaderId, "fragment");
+		GLint length = 0;
+		glGetProgramiv(pending.programId, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> log(length + 1, 0);
+		glGetProgramInfoLog(pending.programId, length, nullptr, log.data());
+		std::cerr << "ShaderManager: " << pending.name << " failed to link\n" << log.data() << "\n";
+	}
+
+	// the program keeps what it needs
+	glDetachShader(pending.programId, pending.vertexShaderId);
+	glDetachShader(pending.programId, pending.fragmentShaderId);
+	glDeleteShader(pending.vertexShaderId);
+	glDeleteShader(pending.fragmentShaderId);
+	if (status != GL_TRUE)
+	{
+		glDeleteProgram(pending.programId);
+		return PROGRAM_FAILED;
+	}
+
+	mCompiledCount++;
+	if (!pending.cachePath.empty())
+	{
+		SaveBinary(pending.cachePath, pending.hash, pending.programId);
+	}
+	return PROGRAM_READY;
+}
+
+void ShaderManager::PrintShaderLog(const Pending& aPending, GLuint aShaderId, const char* aStage) const
+{
+	GLint status = GL_FALSE;
+	glGetShaderiv(aShaderId, GL_COMPILE_STATUS, &status);
+	if (status == GL_TRUE)
+	{
+		return;
+	}
+	GLint length = 0;
+	glGetShaderiv(aShaderId, GL_INFO_LOG_LENGTH, &length);
+	std::vector<GLchar> log(length + 1, 0);
+	glGetShaderInfoLog(aShaderId, length, nullptr, log.data());
+	std::cerr << "ShaderManager: " << aPending.name << " " << aStage << " shader failed to compile\n" << log.data() << "\n";
+}
+
+// file layout: magic, hash, binary format, then the binary up to the end
+GLuint ShaderManager::LoadBinary(const std::string& aPath, uint64_t aHash) const
+{
+	std::ifstream file(aPath, std::ios::binary);
+	if (!file)
+	{
+		return 0;
+	}
+	uint32_t magic = 0;
+	uint64_t hash = 0;
+	GLenum format = 0;
+	file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	if (!file || magic != BINARY_MAGIC || hash != aHash)
+	{
+		return 0;
+	}
+	const std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty())
+	{
+		return 0;
+	}
+
+	const GLuint programId = glCreateProgram();
+	glProgramBinary(programId, format, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint status = GL_FALSE;
+	glGetProgramiv(programId, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		// usually a driver update the version string did not reveal
+		glDeleteProgram(programId);
+		return 0;
+	}
+	return programId;
+}
+
+void ShaderManager::SaveBinary(const std::string& aPath, uint64_t aHash, GLuint aProgramId) const
+{
+	GLint length = 0;
+	glGetProgramiv(aProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(aProgramId, length, nullptr, &format, binary.data());
+
+	std::ofstream file(aPath, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&BINARY_MAGIC), sizeof(BINARY_MAGIC));
+	file.write(reinterpret_cast<const char*>(&aHash), sizeof(aHash));
+	file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+	file.write(binary.data(), binary.size());
+	if (!file)
+	{
+		std::cerr << "ShaderManager: could not write " << aPath << "\n";
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+class VertexLayout;
+
+enum ProgramStatus
+{
+	PROGRAM_PENDING,
+	PROGRAM_READY,
+	// the logs have been printed and the program deleted
+	PROGRAM_FAILED,
+};
+
+// Builds every GL program and reports compile and link errors in one
+// place. With a cache directory and GL 4.1, linked programs are saved
+// with glGetProgramBinary under a hash of their sources, attribute
+// locations and the driver strings, and later starts load them with
+// glProgramBinary instead of compiling. A binary the driver rejects is
+// compiled again and replaced.
+//
+// Builds are started without waiting for them. GL_KHR_parallel_shader_compile
+// lets GetStatus() ask the driver whether one is done without blocking;
+// otherwise GetStatus() finishes at most one build per Update(), so the
+// stalls are spread over frames and the driver gets a head start.
+class ShaderManager
+{
+public:
+	static ShaderManager& Get();
+
+	// after the GL context is current; an empty directory disables the disk cache
+	void SetUp(const std::string& aCacheDirectory);
+	// once per frame, before polling
+	void Update();
+
+	// issues compile and link and returns the program id at once.
+	// aLayouts bind their attribute locations before linking.
+	GLuint BeginProgram(const char* aName, const std::string& aVertexSource, const std::string& aFragmentSource,
+		std::initializer_list<const VertexLayout*> aLayouts);
+	// programs that are not being built count as ready
+	ProgramStatus GetStatus(GLuint aProgramId);
+	// blocks until the build is done
+	ProgramStatus Wait(GLuint aProgramId);
+	// drops a build that is no longer wanted
+	void Cancel(GLuint aProgramId);
+	// BeginProgram() and Wait(); returns 0 if compiling or linking fails
+	GLuint CreateProgram(const char* aName, const std::string& aVertexSource, const std::string& aFragmentSource,
+		std::initializer_list<const VertexLayout*> aLayouts);
+
+	// whole file into aSource; prints an error and returns false if it cannot be read
+	static bool ReadSource(const std::string& aPath, std::string& aSource);
+
+	bool IsBinaryCacheEnabled() const { return mBinaryCache; }
+	bool IsParallelCompileSupported() const { return mParallelCompile; }
+	int GetPendingCount() const { return static_cast<int>(mPending.size()); }
+
+	// programs loaded from the cache / compiled from source
+	int mLoadedCount;
+	int mCompiledCount;
+
+private:
+	// a program whose link status has not been read yet
+	struct Pending
+	{
+		GLuint programId;
+		GLuint vertexShaderId;
+		GLuint fragmentShaderId;
+		std::string name;
+		std::string cachePath; // empty without the binary cache
+		uint64_t hash;
+	};
+
+	ShaderManager();
+
+	GLuint Compile(GLenum aType, const std::string& aSource) const;
+	ProgramStatus Finish(size_t aPending);
+	void PrintShaderLog(const Pending& aPending, GLuint aShaderId, const char* aStage) const;
+	GLuint LoadBinary(const std::string& aPath, uint64_t aHash) const;
+	void SaveBinary(const std::string& aPath, uint64_t aHash, GLuint aProgramId) const;
+
+	std::string mCacheDirectory;
+	// vendor, renderer and version: a new driver must not get old binaries
+	std::string mDriver;
+	bool mBinaryCache;
+	bool mParallelCompile;
+	// builds GetStatus() may still block on this frame, without the extension
+	int mFinishBudget;
+	std::vector<Pending> mPending;
+};
@@ -0,0 +1,602 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+
+#include "SoftwareRasterizer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+// MSVC defines __AVX2__ with /arch:AVX2
+#if defined(__AVX2__)
+#define SOFTWARE_RASTERIZER_AVX2
+#include <immintrin.h>
+#endif
+
+
+
+namespace
+{
+	// pixels shaded together; rows and the groups in them are aligned to it
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	constexpr int GROUP_WIDTH = 8;
+#else
+	constexpr int GROUP_WIDTH = 4;
+#endif
+
+	uint32_t ToByte(float aValue)
+	{
+		return static_cast<uint32_t>(std::min(std::max(aValue, 0.f), 1.f) * 255.f + 0.5f);
+	}
+
+	// nearest texel of a BGR image as 0xAARRGGBB, clamped to the edge
+	uint32_t Fetch(const Image& aImage, int aX, int aY)
+	{
+		const unsigned char* texel = &aImage.pixels[(aY * aImage.width + aX) * 3];
+		return 0xFF000000u | (texel[2] << 16) | (texel[1] << 8) | texel[0];
+	}
+
+#ifndef SOFTWARE_RASTERIZER_SSE2
+	uint32_t Blend(uint32_t aTexel, uint32_t aDst, const Color& aTint, float aAlpha)
+	{
+		const float tint[4] = { aTint.b, aTint.g, aTint.r, 1.f };
+		uint32_t result = 0;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			const int shift = channel * 8;
+			const float src = ((aTexel >> shift) & 0xFF) * tint[channel];
+			const float dst = static_cast<float>((aDst >> shift) & 0xFF);
+			// alpha blends with the same factors as colour in GL
+			const float out = (channel == 3 ? 255.f * aAlpha : src) * aAlpha + dst * (1.f - aAlpha);
+			result |= static_cast<uint32_t>(std::min(out, 255.f) + 0.5f) << shift;
+		}
+		return result;
+	}
+
+	// the fragment shader of SHADER_CIRCLE: distance to the rim over its fwidth
+	float Coverage(float aX, float aY, float aDxX, float aDxY, float aDyX, float aDyY)
+	{
+		const float radius = std::sqrt(aX * aX + aY * aY);
+		const float invRadius = 1.f / std::max(radius, 0.0001f);
+		const float width = std::fabs((aX * aDxX + aY * aDxY) * invRadius) + std::fabs((aX * aDyX + aY * aDyY) * invRadius);
+		return std::min(std::max(0.5f - (radius - 1.f) / std::max(width, 0.0001f), 0.f), 1.f);
+	}
+#else
+	// the vector operations RasterizeLanes() needs, 4 or 8 pixels wide
+	struct Sse2
+	{
+		typedef __m128 F;
+		typedef __m128i I;
+		static constexpr int WIDTH = 4;
+
+		// pixel centres of the lanes relative to the group's first pixel
+		static F Centres() { return _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f); }
+		static F Set(float aValue) { return _mm_set1_ps(aValue); }
+		static F Add(F a, F b) { return _mm_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm_div_ps(a, b); }
+		static F Min(F a, F b) { return _mm_min_ps(a, b); }
+		static F Max(F a, F b) { return _mm_max_ps(a, b); }
+		static F Sqrt(F aValue) { return _mm_sqrt_ps(aValue); }
+		static F And(F a, F b) { return _mm_and_ps(a, b); }
+		static F AndNot(F aMask, F b) { return _mm_andnot_ps(aMask, b); }
+		static F Or(F a, F b) { return _mm_or_ps(a, b); }
+		static F Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+		static F Equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+		static int MoveMask(F aMask) { return _mm_movemask_ps(aMask); }
+
+		static I LoadInt(const void* aSource) { return _mm_loadu_si128(static_cast<const __m128i*>(aSource)); }
+		static void StoreInt(void* aDestination, I aValue) { _mm_storeu_si128(static_cast<__m128i*>(aDestination), aValue); }
+		static I SetInt(int aValue) { return _mm_set1_epi32(aValue); }
+		static I AndInt(I a, I b) { return _mm_and_si128(a, b); }
+		static I AndNotInt(I aMask, I b) { return _mm_andnot_si128(aMask, b); }
+		static I OrInt(I a, I b) { return _mm_or_si128(a, b); }
+		template <int SHIFT> static I ShiftLeft(I aValue) { return _mm_slli_epi32(aValue, SHIFT); }
+		template <int SHIFT> static I ShiftRight(I aValue) { return _mm_srli_epi32(aValue, SHIFT); }
+		static I Truncate(F aValue) { return _mm_cvttps_epi32(aValue); }
+		static I Round(F aValue) { return _mm_cvtps_epi32(aValue); }
+		static F ToFloat(I aValue) { return _mm_cvtepi32_ps(aValue); }
+		static I AsInt(F aValue) { return _mm_castps_si128(aValue); }
+		static F AsFloat(I aValue) { return _mm_castsi128_ps(aValue); }
+	};
+
+#ifdef SOFTWARE_RASTERIZER_AVX2
+	struct Avx2
+	{
+		typedef __m256 F;
+		typedef __m256i I;
+		static constexpr int WIDTH = 8;
+
+		static F Centres() { return _mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f); }
+		static F Set(float aValue) { return _mm256_set1_ps(aValue); }
+		static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+		static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+		static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+		static F Sqrt(F aValue) { return _mm256_sqrt_ps(aValue); }
+		static F And(F a, F b) { return _mm256_and_ps(a, b); }
+		static F AndNot(F aMask, F b) { return _mm256_andnot_ps(aMask, b); }
+		static F Or(F a, F b) { return _mm256_or_ps(a, b); }
+		static F Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static F Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static int MoveMask(F aMask) { return _mm256_movemask_ps(aMask); }
+
+		static I LoadInt(const void* aSource) { return _mm256_loadu_si256(static_cast<const __m256i*>(aSource)); }
+		static void StoreInt(void* aDestination, I aValue) { _mm256_storeu_si256(static_cast<__m256i*>(aDestination), aValue); }
+		static I SetInt(int aValue) { return _mm256_set1_epi32(aValue); }
+		static I AndInt(I a, I b) { return _mm256_and_si256(a, b); }
+		static I AndNotInt(I aMask, I b) { return _mm256_andnot_si256(aMask, b); }
+		static I OrInt(I a, I b) { return _mm256_or_si256(a, b); }
+		template <int SHIFT> static I ShiftLeft(I aValue) { return _mm256_slli_epi32(aValue, SHIFT); }
+		template <int SHIFT> static I ShiftRight(I aValue) { return _mm256_srli_epi32(aValue, SHIFT); }
+		static I Truncate(F aValue) { return _mm256_cvttps_epi32(aValue); }
+		static I Round(F aValue) { return _mm256_cvtps_epi32(aValue); }
+		static F ToFloat(I aValue) { return _mm256_cvtepi32_ps(aValue); }
+		static I AsInt(F aValue) { return _mm256_castps_si256(aValue); }
+		static F AsFloat(I aValue) { return _mm256_castsi256_ps(aValue); }
+	};
+#endif
+
+	template <typename V, int SHIFT>
+	typename V::F Channel(typename V::I aPixels)
+	{
+		return V::ToFloat(V::AndInt(V::template ShiftRight<SHIFT>(aPixels), V::SetInt(0xFF)));
+	}
+
+	template <typename V, int SHIFT>
+	typename V::I Pack(typename V::F aChannel)
+	{
+		return V::template ShiftLeft<SHIFT>(V::Round(V::Min(aChannel, V::Set(255.f))));
+	}
+#endif
+}
+
+
+
+SoftwareRasterizer::SoftwareRasterizer()
+	: mTriangleCount(0)
+	, mBinnedCount(0)
+	, mWidth(0)
+	, mHeight(0)
+	, mStride(0)
+	, mTilesX(0)
+	, mTilesY(0)
+	, mClearPending(false)
+	, mClearValue(0)
+	, mGeneration(0)
+	, mPendingWorkers(0)
+	, mQuit(false)
+	, mNextTile(0)
+{
+}
+
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void SoftwareRasterizer::SetUp(int aWidth, int aHeight, int aThreadCount)
+{
+	mWidth = aWidth;
+	mHeight = aHeight;
+	mStride = (aWidth + GROUP_WIDTH - 1) & ~(GROUP_WIDTH - 1);
+	mTilesX = (aWidth + TILE_SIZE - 1) / TILE_SIZE;
+	mTilesY = (aHeight + TILE_SIZE - 1) / TILE_SIZE;
+	mPixels.assign(mStride * mHeight, 0xFF000000u);
+	mBins.assign(mTilesX * mTilesY, std::vector<uint32_t>());
+	mTriangles.clear();
+
+	if (aThreadCount <= 0)
+	{
+		aThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	// the thread calling Flush() shades tiles as well
+	while (static_cast<int>(mWorkers.size()) + 1 < aThreadCount)
+	{
+		mWorkers.emplace_back(&SoftwareRasterizer::WorkerLoop, this);
+	}
+}
+
+void SoftwareRasterizer::SetTexture(GLuint aTexId, const Image* aImage)
+{
+	for (auto& texture : mTextures)
+	{
+		if (texture.first == aTexId)
+		{
+			texture.second = aImage;
+			return;
+		}
+	}
+	mTextures.emplace_back(aTexId, aImage);
+}
+
+void SoftwareRasterizer::Clear(const Color& aColor)
+{
+	mClearPending = true;
+	mClearValue = (ToByte(aColor.a) << 24) | (ToByte(aColor.r) << 16) | (ToByte(aColor.g) << 8) | ToByte(aColor.b);
+	// nothing drawn before the clear can show
+	mTriangles.clear();
+	for (auto& bin : mBins)
+	{
+		bin.clear();
+	}
+}
+
+void SoftwareRasterizer::DrawTriangle(const RasterVertex& aV0, const RasterVertex& aV1, const RasterVertex& aV2, GLuint aTexId, const Color& aTint,
+	bool aCircle)
+{
+	// nothing is culled, so flip clockwise triangles to counter-clockwise
+	const RasterVertex* v[3] = { &aV0, &aV1, &aV2 };
+	float area = (aV1.x - aV0.x) * (aV2.y - aV0.y) - (aV1.y - aV0.y) * (aV2.x - aV0.x);
+	if (area == 0.f)
+	{
+		return;
+	}
+	if (area < 0.f)
+	{
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	Triangle triangle;
+	triangle.minX = std::max(0, static_cast<int>(std::floor(std::min({ aV0.x, aV1.x, aV2.x }))));
+	triangle.minY = std::max(0, static_cast<int>(std::floor(std::min({ aV0.y, aV1.y, aV2.y }))));
+	triangle.maxX = std::min(mWidth - 1, static_cast<int>(std::ceil(std::max({ aV0.x, aV1.x, aV2.x }))));
+	triangle.maxY = std::min(mHeight - 1, static_cast<int>(std::ceil(std::max({ aV0.y, aV1.y, aV2.y }))));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return;
+	}
+
+	// edge i is opposite vertex i, so its value weights vertex i
+	const float invArea = 1.f / area;
+	triangle.uA = triangle.uB = triangle.uC = 0.f;
+	triangle.vA = triangle.vB = triangle.vC = 0.f;
+	triangle.localXA = triangle.localXB = triangle.localXC = 0.f;
+	triangle.localYA = triangle.localYB = triangle.localYC = 0.f;
+	for (int i = 0; i < 3; i++)
+	{
+		const RasterVertex& from = *v[(i + 1) % 3];
+		const RasterVertex& to = *v[(i + 2) % 3];
+		const float dx = to.x - from.x;
+		const float dy = to.y - from.y;
+		triangle.edgeA[i] = -dy;
+		triangle.edgeB[i] = dx;
+		triangle.edgeC[i] = dy * from.x - dx * from.y;
+		// interior is on the left: left edges go down, top edges go left
+		triangle.topLeft[i] = dy < 0.f || (dy == 0.f && dx < 0.f);
+
+		triangle.uA += triangle.edgeA[i] * v[i]->u * invArea;
+		triangle.uB += triangle.edgeB[i] * v[i]->u * invArea;
+		triangle.uC += triangle.edgeC[i] * v[i]->u * invArea;
+		triangle.vA += triangle.edgeA[i] * v[i]->v * invArea;
+		triangle.vB += triangle.edgeB[i] * v[i]->v * invArea;
+		triangle.vC += triangle.edgeC[i] * v[i]->v * invArea;
+		triangle.localXA += triangle.edgeA[i] * v[i]->localX * invArea;
+		triangle.localXB += triangle.edgeB[i] * v[i]->localX * invArea;
+		triangle.localXC += triangle.edgeC[i] * v[i]->localX * invArea;
+		triangle.localYA += triangle.edgeA[i] * v[i]->localY * invArea;
+		triangle.localYB += triangle.edgeB[i] * v[i]->localY * invArea;
+		triangle.localYC += triangle.edgeC[i] * v[i]->localY * invArea;
+	}
+	triangle.circle = aCircle;
+	triangle.texture = FindTexture(aTexId);
+	triangle.tint = aTint;
+
+	const uint32_t index = static_cast<uint32_t>(mTriangles.size());
+	mTriangles.push_back(triangle);
+	for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+	{
+		for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+		{
+			mBins[tileY * mTilesX + tileX].push_back(index);
+		}
+	}
+}
+
+void SoftwareRasterizer::Flush()
+{
+	mTriangleCount = static_cast<int>(mTriangles.size());
+	mBinnedCount = 0;
+	for (const auto& bin : mBins)
+	{
+		mBinnedCount += static_cast<int>(bin.size());
+	}
+
+	mNextTile = 0;
+	if (mWorkers.empty())
+	{
+		RunTiles();
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mPendingWorkers = static_cast<int>(mWorkers.size());
+			mGeneration++;
+		}
+		mWake.notify_all();
+		RunTiles();
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mPendingWorkers == 0; });
+	}
+
+	mClearPending = false;
+	mTriangles.clear();
+	for (auto& bin : mBins)
+	{
+		bin.clear();
+	}
+}
+
+void SoftwareRasterizer::ReadPixels(Image& aImage) const
+{
+	aImage.width = mWidth;
+	aImage.height = mHeight;
+	aImage.pixels.resize(mWidth * mHeight * 3);
+
+	unsigned char* dst = aImage.pixels.data();
+	for (int y = 0; y < mHeight; y++)
+	{
+		const uint32_t* row = &mPixels[y * mStride];
+		for (int x = 0; x < mWidth; x++)
+		{
+			*dst++ = static_cast<unsigned char>(row[x]);
+			*dst++ = static_cast<unsigned char>(row[x] >> 8);
+			*dst++ = static_cast<unsigned char>(row[x] >> 16);
+		}
+	}
+}
+
+void SoftwareRasterizer::WorkerLoop()
+{
+	unsigned generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [&] { return mQuit || mGeneration != generation; });
+			if (mQuit)
+			{
+				return;
+			}
+			generation = mGeneration;
+		}
+
+		RunTiles();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (--mPendingWorkers == 0)
+		{
+			mDone.notify_one();
+		}
+	}
+}
+
+// tiles never share pixels, so every thread just takes the next one
+void SoftwareRasterizer::RunTiles()
+{
+	const int tileCount = mTilesX * mTilesY;
+	for (int tile = mNextTile++; tile < tileCount; tile = mNextTile++)
+	{
+		RasterizeTile(tile);
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(int aTile)
+{
+	const int tileX = (aTile % mTilesX) * TILE_SIZE;
+	const int tileY = (aTile / mTilesX) * TILE_SIZE;
+	const int lastX = std::min(tileX + TILE_SIZE, mWidth) - 1;
+	const int lastY = std::min(tileY + TILE_SIZE, mHeight) - 1;
+
+	if (mClearPending)
+	{
+		for (int y = tileY; y <= lastY; y++)
+		{
+			uint32_t* row = &mPixels[y * mStride];
+			std::fill(row + tileX, row + lastX + 1, mClearValue);
+		}
+	}
+
+	// bins hold triangles in submission order, which keeps blending in order
+	for (auto index : mBins[aTile])
+	{
+		const Triangle& triangle = mTriangles[index];
+		// groups start on multiples of their width and never cross tiles
+		const int minX = std::max(triangle.minX, tileX) & ~(GROUP_WIDTH - 1);
+		const int maxX = std::min(triangle.maxX, lastX);
+		const int minY = std::max(triangle.minY, tileY);
+		const int maxY = std::min(triangle.maxY, lastY);
+		for (int y = minY; y <= maxY; y++)
+		{
+			RasterizeRow(triangle, y, minX, maxX, &mPixels[y * mStride]);
+		}
+	}
+}
+
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+// RasterizeRow() V::WIDTH pixels at a time
+template <typename V>
+void SoftwareRasterizer::RasterizeLanes(const Triangle& aTriangle, int aY, int aMinX, int aMaxX, uint32_t* aRow) const
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+	// sample at pixel centres like GL
+	const float y = aY + 0.5f;
+	const Image* texture = aTriangle.texture;
+	const float texWidth = texture != nullptr ? static_cast<float>(texture->width) : 1.f;
+	const float texHeight = texture != nullptr ? static_cast<float>(texture->height) : 1.f;
+
+	const F zero = V::Set(0.f);
+	const F centres = V::Centres();
+	F edgeA[3], edgeRow[3], topLeft[3];
+	for (int i = 0; i < 3; i++)
+	{
+		edgeA[i] = V::Set(aTriangle.edgeA[i]);
+		edgeRow[i] = V::Set(aTriangle.edgeB[i] * y + aTriangle.edgeC[i]);
+		topLeft[i] = V::AsFloat(V::SetInt(aTriangle.topLeft[i] ? -1 : 0));
+	}
+	const F uA = V::Set(aTriangle.uA * texWidth);
+	const F uRow = V::Set((aTriangle.uB * y + aTriangle.uC) * texWidth);
+	const F vA = V::Set(aTriangle.vA * texHeight);
+	const F vRow = V::Set((aTriangle.vB * y + aTriangle.vC) * texHeight);
+	const F maxU = V::Set(texWidth - 1.f);
+	const F maxV = V::Set(texHeight - 1.f);
+
+	const Color& tint = aTriangle.tint;
+	const F one = V::Set(1.f);
+	const F epsilon = V::Set(0.0001f);
+	const F signMask = V::Set(-0.f);
+	const F localXA = V::Set(aTriangle.localXA);
+	const F localXB = V::Set(aTriangle.localXB);
+	const F localXRow = V::Set(aTriangle.localXB * y + aTriangle.localXC);
+	const F localYA = V::Set(aTriangle.localYA);
+	const F localYB = V::Set(aTriangle.localYB);
+	const F localYRow = V::Set(aTriangle.localYB * y + aTriangle.localYC);
+
+	for (int x = aMinX; x <= aMaxX; x += V::WIDTH)
+	{
+		const F pixelX = V::Add(V::Set(static_cast<float>(x)), centres);
+		F inside = V::AsFloat(V::SetInt(-1));
+		for (int i = 0; i < 3; i++)
+		{
+			const F w = V::Add(V::Mul(edgeA[i], pixelX), edgeRow[i]);
+			const F covered = V::Or(V::Greater(w, zero), V::And(V::Equal(w, zero), topLeft[i]));
+			inside = V::And(inside, covered);
+		}
+		const int mask = V::MoveMask(inside);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		uint32_t texels[V::WIDTH];
+		std::fill(texels, texels + V::WIDTH, 0xFF000000u);
+		if (texture != nullptr)
+		{
+			const F u = V::Add(V::Mul(uA, pixelX), uRow);
+			const F v = V::Add(V::Mul(vA, pixelX), vRow);
+			int32_t texelX[V::WIDTH], texelY[V::WIDTH];
+			V::StoreInt(texelX, V::Truncate(V::Min(V::Max(u, zero), maxU)));
+			V::StoreInt(texelY, V::Truncate(V::Min(V::Max(v, zero), maxV)));
+			for (int lane = 0; lane < V::WIDTH; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					texels[lane] = Fetch(*texture, texelX[lane], texelY[lane]);
+				}
+			}
+		}
+
+		// the alpha channel of the texture is always one
+		F alpha = V::Set(tint.a);
+		if (aTriangle.circle)
+		{
+			// Coverage() V::WIDTH lanes at a time
+			const F localX = V::Add(V::Mul(localXA, pixelX), localXRow);
+			const F localY = V::Add(V::Mul(localYA, pixelX), localYRow);
+			const F radius = V::Sqrt(V::Add(V::Mul(localX, localX), V::Mul(localY, localY)));
+			const F invRadius = V::Div(one, V::Max(radius, epsilon));
+			const F dx = V::Mul(V::Add(V::Mul(localX, localXA), V::Mul(localY, localYA)), invRadius);
+			const F dy = V::Mul(V::Add(V::Mul(localX, localXB), V::Mul(localY, localYB)), invRadius);
+			const F width = V::Max(V::Add(V::AndNot(signMask, dx), V::AndNot(signMask, dy)), epsilon);
+			const F distance = V::Div(V::Sub(radius, one), width);
+			const F coverage = V::Min(V::Max(V::Sub(V::Set(0.5f), distance), zero), one);
+			alpha = V::Mul(alpha, coverage);
+		}
+		const F invAlpha = V::Sub(one, alpha);
+		const F srcB = V::Mul(V::Set(tint.b), alpha);
+		const F srcG = V::Mul(V::Set(tint.g), alpha);
+		const F srcR = V::Mul(V::Set(tint.r), alpha);
+		const F srcA = V::Mul(V::Set(255.f), V::Mul(alpha, alpha));
+
+		const I src = V::LoadInt(texels);
+		const I dst = V::LoadInt(aRow + x);
+		const F outB = V::Add(V::Mul(Channel<V, 0>(src), srcB), V::Mul(Channel<V, 0>(dst), invAlpha));
+		const F outG = V::Add(V::Mul(Channel<V, 8>(src), srcG), V::Mul(Channel<V, 8>(dst), invAlpha));
+		const F outR = V::Add(V::Mul(Channel<V, 16>(src), srcR), V::Mul(Channel<V, 16>(dst), invAlpha));
+		const F outA = V::Add(srcA, V::Mul(Channel<V, 24>(dst), invAlpha));
+		const I out = V::OrInt(V::OrInt(Pack<V, 0>(outB), Pack<V, 8>(outG)), V::OrInt(Pack<V, 16>(outR), Pack<V, 24>(outA)));
+
+		const I keep = V::AsInt(inside);
+		V::StoreInt(aRow + x, V::OrInt(V::AndInt(keep, out), V::AndNotInt(keep, dst)));
+	}
+}
+#endif
+
+void SoftwareRasterizer::RasterizeRow(const Triangle& aTriangle, int aY, int aMinX, int aMaxX, uint32_t* aRow) const
+{
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	RasterizeLanes<Avx2>(aTriangle, aY, aMinX, aMaxX, aRow);
+#elif defined(SOFTWARE_RASTERIZER_SSE2)
+	RasterizeLanes<Sse2>(aTriangle, aY, aMinX, aMaxX, aRow);
+#else
+	// sample at pixel centres like GL
+	const float y = aY + 0.5f;
+	const Image* texture = aTriangle.texture;
+	const float texWidth = texture != nullptr ? static_cast<float>(texture->width) : 1.f;
+	const float texHeight = texture != nullptr ? static_cast<float>(texture->height) : 1.f;
+
+	for (int x = aMinX; x <= aMaxX; x++)
+	{
+		const float pixelX = x + 0.5f;
+		bool inside = true;
+		for (int i = 0; i < 3; i++)
+		{
+			const float w = aTriangle.edgeA[i] * pixelX + aTriangle.edgeB[i] * y + aTriangle.edgeC[i];
+			inside = inside && (w > 0.f || (w == 0.f && aTriangle.topLeft[i]));
+		}
+		if (!inside)
+		{
+			continue;
+		}
+
+		uint32_t texel = 0xFF000000u;
+		if (texture != nullptr)
+		{
+			const float u = (aTriangle.uA * pixelX + aTriangle.uB * y + aTriangle.uC) * texWidth;
+			const float v = (aTriangle.vA * pixelX + aTriangle.vB * y + aTriangle.vC) * texHeight;
+			const int texelX = static_cast<int>(std::min(std::max(u, 0.f), texWidth - 1.f));
+			const int texelY = static_cast<int>(std::min(std::max(v, 0.f), texHeight - 1.f));
+			texel = Fetch(*texture, texelX, texelY);
+		}
+		float alpha = aTriangle.tint.a;
+		if (aTriangle.circle)
+		{
+			const float localX = aTriangle.localXA * pixelX + aTriangle.localXB * y + aTriangle.localXC;
+			const float localY = aTriangle.localYA * pixelX + aTriangle.localYB * y + aTriangle.localYC;
+			alpha *= Coverage(localX, localY, aTriangle.localXA, aTriangle.localYA, aTriangle.localXB, aTriangle.localYB);
+		}
+		aRow[x] = Blend(texel, aRow[x], aTriangle.tint, alpha);
+	}
+#endif
+}
+
+// unknown ids sample black like an incomplete texture in GL
+const Image* SoftwareRasterizer::FindTexture(GLuint aTexId) const
+{
+	for (const auto& texture : mTextures)
+	{
+		if (texture.first == aTexId)
+		{
+			return texture.second;
+		}
+	}
+	return nullptr;
+}
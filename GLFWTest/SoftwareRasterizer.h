@@ -0,0 +1,106 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Color.h"
+#include "Image.h"
+
+// screen space vertex of the software rasterizer
+struct RasterVertex
+{
+	float x, y; // pixels, origin at the bottom left like glViewport
+	float u, v;
+	// -1..1 across the quad of a circle, see SHADER_CIRCLE
+	float localX, localY;
+};
+
+// Draws textured triangles into a CPU framebuffer, for hosts without a
+// usable GL driver. Triangles are binned to 64x64 tiles in submission
+// order and the tiles are shaded in parallel, eight pixels at a time with
+// AVX2 edge functions or four with SSE2, whichever the build targets. Sampling is GL_NEAREST / GL_CLAMP_TO_EDGE and
+// blending is GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA like the GL path.
+// Circle triangles get the same anti-aliased disc as SHADER_CIRCLE.
+class SoftwareRasterizer
+{
+public:
+	static constexpr int TILE_SIZE = 64;
+
+	SoftwareRasterizer();
+	~SoftwareRasterizer();
+	// aThreadCount 0 uses every hardware thread, the caller's included
+	void SetUp(int aWidth, int aHeight, int aThreadCount = 0);
+	// textures are looked up by the same ids the GL path draws with
+	void SetTexture(GLuint aTexId, const Image* aImage);
+
+	// deferred to the next Flush(), where every tile clears itself
+	void Clear(const Color& aColor);
+	void DrawTriangle(const RasterVertex& aV0, const RasterVertex& aV1, const RasterVertex& aV2, GLuint aTexId, const Color& aTint,
+		bool aCircle = false);
+	// rasterizes everything drawn since the last Flush()
+	void Flush();
+	// same layout as RenderTarget::ReadPixels (BGR, bottom row first)
+	void ReadPixels(Image& aImage) const;
+
+	int GetWidth() const { return mWidth; }
+	int GetHeight() const { return mHeight; }
+	int GetThreadCount() const { return static_cast<int>(mWorkers.size()) + 1; }
+
+	// statistics of the last Flush()
+	int mTriangleCount;
+	int mBinnedCount;
+
+private:
+	struct Triangle
+	{
+		// w = a * x + b * y + c per edge, positive inside
+		float edgeA[3], edgeB[3], edgeC[3];
+		// pixel centres exactly on an edge belong to top and left edges only
+		bool topLeft[3];
+		// u and v as planes over the screen
+		float uA, uB, uC;
+		float vA, vB, vC;
+		// local circle coordinates, only used when circle is set
+		float localXA, localXB, localXC;
+		float localYA, localYB, localYC;
+		bool circle;
+		const Image* texture;
+		Color tint;
+		int minX, minY, maxX, maxY;
+	};
+
+	void WorkerLoop();
+	void RunTiles();
+	void RasterizeTile(int aTile);
+	void RasterizeRow(const Triangle& aTriangle, int aY, int aMinX, int aMaxX, uint32_t* aRow) const;
+	template <typename V>
+	void RasterizeLanes(const Triangle& aTriangle, int aY, int aMinX, int aMaxX, uint32_t* aRow) const;
+	const Image* FindTexture(GLuint aTexId) const;
+
+	int mWidth;
+	int mHeight;
+	// rows are padded to whole groups of pixels shaded together
+	int mStride;
+	int mTilesX;
+	int mTilesY;
+	std::vector<uint32_t> mPixels; // 0xAARRGGBB
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBins;
+	std::vector<std::pair<GLuint, const Image*>> mTextures;
+	bool mClearPending;
+	uint32_t mClearValue;
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+	unsigned mGeneration;
+	int mPendingWorkers;
+	bool mQuit;
+	std::atomic<int> mNextTile;
+};
@@ -0,0 +1,352 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cmath>
+#include <cstring>
+
+#include "GLStateCache.h"
+#include "Mesh.h"
+#include "QuadIndexBuffer.h"
+#include "Shader.h"
+#include "SoftwareRasterizer.h"
+#include "SpriteBatch.h"
+
+
+
+SpriteBatch::SpriteBatch()
+	: mSpriteCount(0)
+	, mDrawCallCount(0)
+	, mShader(nullptr)
+	, mRasterizer(nullptr)
+	, mInstancing(false)
+	, mQuadVertexArrayId(0)
+{
+	mat4x4_identity(mViewProj);
+}
+
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+void SpriteBatch::SetUp(const Shader& aShader, bool aAllowInstancing)
+{
+	mShader = &aShader;
+	// glVertexAttribDivisor is core since 3.3
+	mInstancing = aAllowInstancing && GLAD_GL_VERSION_3_3;
+	mStreamBuffer.SetUp(GL_ARRAY_BUFFER, 256 * 1024);
+	if (!mInstancing)
+	{
+		QuadIndexBuffer::Get().Reserve(QuadIndexBuffer::QUAD_MAX);
+		if (GLAD_GL_VERSION_3_0 && mQuadVertexArrayId == 0)
+		{
+			glGenVertexArrays(1, &mQuadVertexArrayId);
+		}
+	}
+}
+
+void SpriteBatch::SetUp(SoftwareRasterizer& aRasterizer)
+{
+	mRasterizer = &aRasterizer;
+	mInstancing = false;
+}
+
+void SpriteBatch::Begin(mat4x4 aViewProj)
+{
+	mat4x4_dup(mViewProj, aViewProj);
+	mQueue.Clear();
+	mPayloads.clear();
+	mProgramIndices.clear();
+	mTextureIndices.clear();
+	mMeshIndices.clear();
+}
+
+void SpriteBatch::Draw(const Mesh& aMesh, GLuint aTexId, const UvRect& aUvRect, Vec2 aPos, Vec2 aScale, float aRotation, const Color& aTint,
+	int aLayer, float aDepth, const Shader* aShader)
+{
+	const Shader* shader = aShader != nullptr ? aShader : mShader;
+	if (shader != nullptr)
+	{
+		// a program still being built draws with its fallback
+		shader = &shader->GetActive();
+	}
+	const GLuint programId = shader != nullptr ? shader->GetProgramId() : 0;
+	const uint64_t key = RenderQueue::MakeKey(aLayer, FrameIndex(mProgramIndices, programId),
+		FrameIndex(mTextureIndices, aTexId), FrameIndex(mMeshIndices, aMesh.GetId()), aDepth);
+	mQueue.Push(key, static_cast<uint32_t>(mPayloads.size()));
+	mPayloads.push_back({ &aMesh, shader, aTexId, { { aPos.x, aPos.y, aScale.x, aScale.y }, aUvRect, aTint, aRotation } });
+}
+
+void SpriteBatch::End()
+{
+	mSpriteCount = static_cast<int>(mPayloads.size());
+	mDrawCallCount = 0;
+	// the rasterizer still has to flush a pending clear
+	if (mPayloads.empty() && mRasterizer == nullptr)
+	{
+		return;
+	}
+
+	// stable, so equal keys keep their submission order
+	mQueue.Sort();
+
+	if (mRasterizer != nullptr)
+	{
+		DrawSoftware();
+		return;
+	}
+
+	auto& state = GLStateCache::Get();
+	state.SetEnabled(GL_BLEND, true);
+	state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	if (mInstancing)
+	{
+		DrawInstanced();
+	}
+	else
+	{
+		DrawEach();
+	}
+
+	// keep later attribute setup out of the meshes' vertex arrays
+	state.BindVertexArray(0);
+	state.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int SpriteBatch::FrameIndex(std::unordered_map<unsigned int, unsigned int>& aIndices, unsigned int aId)
+{
+	const unsigned int next = static_cast<unsigned int>(aIndices.size());
+	return aIndices.emplace(aId, next).first->second;
+}
+
+void SpriteBatch::PackInstance(const Instance& aInstance, unsigned char* aDestination)
+{
+	const VertexLayout& layout = Shader::GetInstanceLayout();
+	layout.Pack(0, aInstance.transform, aDestination);
+	layout.Pack(1, &aInstance.uvRect.u0, aDestination);
+	layout.Pack(2, &aInstance.tint.r, aDestination);
+	layout.Pack(3, &aInstance.rotation, aDestination);
+}
+
+// the cache drops both calls unless the program changes
+void SpriteBatch::UseShader(const Shader& aShader)
+{
+	auto& state = GLStateCache::Get();
+	state.UseProgram(aShader.GetProgramId());
+	state.UniformMatrix4fv(aShader.mMvpLocation, (const GLfloat*)mViewProj);
+}
+
+// one glDrawArraysInstanced per run of commands with the same state bits.
+// Instancing needs GL 3.3, so every mesh has a vertex array here and the
+// instance arrays are set up in it.
+void SpriteBatch::DrawInstanced()
+{
+	auto& state = GLStateCache::Get();
+	const auto& commands = mQueue.GetCommands();
+	const VertexLayout& layout = Shader::GetInstanceLayout();
+	const int stride = layout.GetStride();
+	GLintptr offset = 0;
+	auto* instances = static_cast<unsigned char*>(mStreamBuffer.Map(commands.size() * stride, offset));
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		PackInstance(mPayloads[commands[i].payload].instance, instances + i * stride);
+	}
+	mStreamBuffer.Unmap();
+
+	size_t runBegin = 0;
+	while (runBegin < commands.size())
+	{
+		const uint64_t runState = commands[runBegin].key & RenderQueue::STATE_MASK;
+		const Payload& first = mPayloads[commands[runBegin].payload];
+		size_t runEnd = runBegin + 1;
+		while (runEnd < commands.size() && (commands[runEnd].key & RenderQueue::STATE_MASK) == runState)
+		{
+			runEnd++;
+		}
+
+		UseShader(*first.shader);
+		state.BindTexture(0, first.texId);
+		first.mesh->Bind();
+
+		// the base instance is selected through the attribute offsets
+		state.BindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.GetId());
+		layout.Apply(offset + runBegin * stride);
+		for (const auto& attribute : layout.GetAttributes())
+		{
+			glVertexAttribDivisor(attribute.location, 1);
+		}
+
+		glDrawArraysInstanced(first.mesh->GetMode(), 0, first.mesh->GetCount(), static_cast<GLsizei>(runEnd - runBegin));
+		mDrawCallCount++;
+		runBegin = runEnd;
+	}
+	mStreamBuffer.EndFrame();
+}
+
+// fallback without instanced arrays: per-object data as constant
+// attributes, quads merged by DrawQuads()
+void SpriteBatch::DrawEach()
+{
+	auto& state = GLStateCache::Get();
+	const auto& commands = mQueue.GetCommands();
+	const Mesh* boundMesh = nullptr;
+	size_t i = 0;
+	while (i < commands.size())
+	{
+		const Payload& sprite = mPayloads[commands[i].payload];
+		if (sprite.mesh->IsQuad())
+		{
+			// the mesh does not matter, every quad uses the same indices
+			size_t runEnd = i + 1;
+			while (runEnd < commands.size() && runEnd - i < QuadIndexBuffer::QUAD_MAX)
+			{
+				const Payload& next = mPayloads[commands[runEnd].payload];
+				if (!next.mesh->IsQuad() || next.shader != sprite.shader || next.texId != sprite.texId)
+				{
+					break;
+				}
+				runEnd++;
+			}
+			DrawQuads(i, runEnd);
+			boundMesh = nullptr;
+			i = runEnd;
+			continue;
+		}
+
+		UseShader(*sprite.shader);
+		state.BindTexture(0, sprite.texId);
+		// attribute locations are the same in every program
+		if (sprite.mesh != boundMesh)
+		{
+			sprite.mesh->Bind();
+			boundMesh = sprite.mesh;
+			// an instanced batch may have left its arrays enabled in the vertex array
+			if (sprite.mesh->GetVertexArrayId() != 0)
+			{
+				for (const auto& attribute : Shader::GetInstanceLayout().GetAttributes())
+				{
+					glDisableVertexAttribArray(attribute.location);
+				}
+			}
+		}
+
+		const Instance& instance = sprite.instance;
+		glVertexAttrib4fv(Shader::TRANSFORM_LOCATION, instance.transform);
+		glVertexAttrib4fv(Shader::UV_RECT_LOCATION, &instance.uvRect.u0);
+		glVertexAttrib4fv(Shader::TINT_LOCATION, &instance.tint.r);
+		glVertexAttrib1f(Shader::ROTATION_LOCATION, instance.rotation);
+		glDrawArrays(sprite.mesh->GetMode(), 0, sprite.mesh->GetCount());
+		mDrawCallCount++;
+		i++;
+	}
+	mStreamBuffer.EndFrame();
+}
+
+// Streams the packed mesh vertices followed by the instance data, copied
+// to each of the four vertices, and draws them as GL_TRIANGLES over the
+// shared QuadIndexBuffer. The shader reads the instance attributes per
+// vertex instead of per instance and needs no changes.
+void SpriteBatch::DrawQuads(size_t aBegin, size_t aEnd)
+{
+	auto& state = GLStateCache::Get();
+	const auto& commands = mQueue.GetCommands();
+	const VertexLayout& vertexLayout = Shader::GetVertexLayout();
+	const VertexLayout& instanceLayout = Shader::GetInstanceLayout();
+	const int quadCount = static_cast<int>(aEnd - aBegin);
+	const int quadVertexBytes = 4 * vertexLayout.GetStride();
+	const int instanceStride = instanceLayout.GetStride();
+	const GLsizeiptr vertexBytes = quadCount * quadVertexBytes;
+
+	GLintptr offset = 0;
+	auto* vertices = static_cast<unsigned char*>(mStreamBuffer.Map(vertexBytes + quadCount * 4 * instanceStride, offset));
+	unsigned char* instances = vertices + vertexBytes;
+	for (size_t i = aBegin; i < aEnd; i++)
+	{
+		const Payload& sprite = mPayloads[commands[i].payload];
+		std::memcpy(vertices, sprite.mesh->GetPackedVertices().data(), quadVertexBytes);
+		PackInstance(sprite.instance, instances);
+		for (int vertex = 1; vertex < 4; vertex++)
+		{
+			std::memcpy(instances + vertex * instanceStride, instances, instanceStride);
+		}
+		vertices += quadVertexBytes;
+		instances += 4 * instanceStride;
+	}
+	mStreamBuffer.Unmap();
+
+	const Payload& first = mPayloads[commands[aBegin].payload];
+	UseShader(*first.shader);
+	state.BindTexture(0, first.texId);
+	state.BindVertexArray(mQuadVertexArrayId);
+	QuadIndexBuffer::Get().Bind();
+	state.BindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.GetId());
+	vertexLayout.Apply(offset);
+	instanceLayout.Apply(offset + vertexBytes);
+	QuadIndexBuffer::Get().Draw(quadCount);
+	mDrawCallCount++;
+
+	// the default vertex array is shared with the constant attribute draws
+	if (mQuadVertexArrayId == 0)
+	{
+		for (const auto& attribute : instanceLayout.GetAttributes())
+		{
+			glDisableVertexAttribArray(attribute.location);
+		}
+	}
+}
+
+// the vertex shader of Shader.cpp on the CPU, then one triangle per fan or strip step
+void SpriteBatch::DrawSoftware()
+{
+	const float halfWidth = mRasterizer->GetWidth() * 0.5f;
+	const float halfHeight = mRasterizer->GetHeight() * 0.5f;
+	std::vector<RasterVertex> vertices;
+	for (const auto& command : mQueue.GetCommands())
+	{
+		const Payload& sprite = mPayloads[command.payload];
+		const Instance& instance = sprite.instance;
+		const float c = std::cos(instance.rotation);
+		const float s = std::sin(instance.rotation);
+		const std::vector<float>& local = sprite.mesh->GetVertices();
+		// the rainbow fill is not emulated, those circles show the texture
+		const bool circle = sprite.shader != nullptr && sprite.shader->GetType() != SHADER_SPRITE;
+
+		vertices.resize(sprite.mesh->GetCount());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const float x = local[i * 4] * instance.transform[2];
+			const float y = local[i * 4 + 1] * instance.transform[3];
+			vec4 world = { c * x - s * y + instance.transform[0], s * x + c * y + instance.transform[1], 0.f, 1.f };
+			vec4 clip;
+			mat4x4_mul_vec4(clip, mViewProj, world);
+
+			const float u = local[i * 4 + 2];
+			const float v = local[i * 4 + 3];
+			vertices[i].x = (clip[0] / clip[3] + 1.f) * halfWidth;
+			vertices[i].y = (clip[1] / clip[3] + 1.f) * halfHeight;
+			vertices[i].u = instance.uvRect.u0 + (instance.uvRect.u1 - instance.uvRect.u0) * u;
+			vertices[i].v = instance.uvRect.v0 + (instance.uvRect.v1 - instance.uvRect.v0) * v;
+			vertices[i].localX = u * 2.f - 1.f;
+			vertices[i].localY = v * 2.f - 1.f;
+		}
+
+		const GLenum mode = sprite.mesh->GetMode();
+		for (size_t i = 2; i < vertices.size(); i++)
+		{
+			if (mode == GL_TRIANGLE_FAN)
+			{
+				mRasterizer->DrawTriangle(vertices[0], vertices[i - 1], vertices[i], sprite.texId, instance.tint, circle);
+			}
+			else if (mode == GL_TRIANGLE_STRIP)
+			{
+				mRasterizer->DrawTriangle(vertices[i - 2], vertices[i - 1], vertices[i], sprite.texId, instance.tint, circle);
+			}
+			else if (mode == GL_TRIANGLES && i % 3 == 2)
+			{
+				mRasterizer->DrawTriangle(vertices[i - 2], vertices[i - 1], vertices[i], sprite.texId, instance.tint, circle);
+			}
+		}
+		mDrawCallCount++;
+	}
+	mRasterizer->Flush();
+}
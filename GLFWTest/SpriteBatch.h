@@ -0,0 +1,95 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <unordered_map>
+#include <vector>
+#include "Color.h"
+#include "linmath.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+#include "TextureAtlas.h"
+#include "Vec2.h"
+
+class Mesh;
+class Shader;
+class SoftwareRasterizer;
+
+// Collects every sprite drawn in a frame as render queue commands and
+// flushes them sorted by layer, program, texture, mesh and depth. With
+// GL 3.3 each run of equal state is a single instanced draw fed from a
+// per-frame instance buffer; older contexts draw each sprite with its
+// instance data set as constant attributes, except quads, which are
+// streamed with their instance data per vertex and merged into one
+// indexed draw per program and texture. Sprites may pick their own
+// shader; it is part of the sort key, so each program is bound once. The
+// software backend runs the vertex shader on the CPU and hands triangles
+// to a SoftwareRasterizer.
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+	~SpriteBatch();
+	void SetUp(const Shader& aShader, bool aAllowInstancing = true);
+	// draws without any GL calls
+	void SetUp(SoftwareRasterizer& aRasterizer);
+
+	void Begin(mat4x4 aViewProj);
+	// aUvRect selects the part of the texture mapped to the mesh uvs.
+	// Higher layers are drawn on top; aDepth orders sprites within a layer.
+	// aShader nullptr uses the shader given to SetUp(); shaders still being
+	// built draw with their fallback.
+	void Draw(const Mesh& aMesh, GLuint aTexId, const UvRect& aUvRect, Vec2 aPos, Vec2 aScale, float aRotation, const Color& aTint,
+		int aLayer = 0, float aDepth = 0.f, const Shader* aShader = nullptr);
+	void End();
+
+	bool IsInstancing() const { return mInstancing; }
+	const StreamBuffer& GetStreamBuffer() const { return mStreamBuffer; }
+
+	// statistics of the last End()
+	int mSpriteCount;
+	int mDrawCallCount;
+
+private:
+	// per-instance data, packed with Shader::GetInstanceLayout() when instancing
+	struct Instance
+	{
+		float transform[4]; // position xy, scale xy
+		UvRect uvRect;
+		Color tint;
+		float rotation;
+	};
+
+	// payload of a render queue command
+	struct Payload
+	{
+		const Mesh* mesh;
+		const Shader* shader;
+		GLuint texId;
+		Instance instance;
+	};
+
+	// the index of aId among the ids used this frame, counted from 0 in the
+	// order they first appear; the render queue key holds these
+	static unsigned int FrameIndex(std::unordered_map<unsigned int, unsigned int>& aIndices, unsigned int aId);
+	static void PackInstance(const Instance& aInstance, unsigned char* aDestination);
+	void UseShader(const Shader& aShader);
+	void DrawInstanced();
+	void DrawEach();
+	// commands [aBegin, aEnd) must all be quads with the same shader and texture
+	void DrawQuads(size_t aBegin, size_t aEnd);
+	void DrawSoftware();
+
+	const Shader* mShader;
+	SoftwareRasterizer* mRasterizer;
+	bool mInstancing;
+	StreamBuffer mStreamBuffer;
+	// attribute setup of DrawQuads(), 0 without vertex array objects
+	GLuint mQuadVertexArrayId;
+	mat4x4 mViewProj;
+	RenderQueue mQueue;
+	std::vector<Payload> mPayloads;
+	// per-frame indices of programs, textures and meshes, by GL name or mesh id
+	std::unordered_map<unsigned int, unsigned int> mProgramIndices;
+	std::unordered_map<unsigned int, unsigned int> mTextureIndices;
+	std::unordered_map<unsigned int, unsigned int> mMeshIndices;
+};
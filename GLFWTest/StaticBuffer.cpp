@@ -0,0 +1,36 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include "GLStateCache.h"
+#include "StaticBuffer.h"
+
+
+
+StaticBuffer::StaticBuffer()
+	: mTarget(GL_ARRAY_BUFFER)
+	, mBufferId(0)
+	, mSize(0)
+{
+}
+
+
+StaticBuffer::~StaticBuffer()
+{
+}
+
+void StaticBuffer::SetUp(GLenum aTarget, const void* aData, GLsizeiptr aSize)
+{
+	mTarget = aTarget;
+	mSize = aSize;
+	if (mBufferId == 0)
+	{
+		glGenBuffers(1, &mBufferId);
+	}
+	GLStateCache::Get().BindBuffer(mTarget, mBufferId);
+	glBufferData(mTarget, mSize, aData, GL_STATIC_DRAW);
+}
+
+void StaticBuffer::Bind() const
+{
+	GLStateCache::Get().BindBuffer(mTarget, mBufferId);
+}
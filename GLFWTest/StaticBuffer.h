@@ -0,0 +1,21 @@
+#pragma once
+
+#include "glad/glad.h"
+
+// Buffer object for immutable meshes, uploaded once at load.
+class StaticBuffer
+{
+public:
+	StaticBuffer();
+	~StaticBuffer();
+	void SetUp(GLenum aTarget, const void* aData, GLsizeiptr aSize);
+	void Bind() const;
+
+	GLuint GetId() const { return mBufferId; }
+	GLsizeiptr GetSize() const { return mSize; }
+
+private:
+	GLenum mTarget;
+	GLuint mBufferId;
+	GLsizeiptr mSize;
+};
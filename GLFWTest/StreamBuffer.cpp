@@ -0,0 +1,189 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+
+
+StreamBuffer::StreamBuffer()
+	: mFrameBytes(0)
+	, mTotalBytes(0)
+	, mOrphanCount(0)
+	, mWaitCount(0)
+	, mTarget(GL_ARRAY_BUFFER)
+	, mBufferId(0)
+	, mSize(0)
+	, mHead(0)
+	, mRangeBegin(0)
+	, mMappedOffset(0)
+	, mMappedSize(0)
+	, mUseMapRange(false)
+	, mUseFences(false)
+	, mCurrentFrameBytes(0)
+{
+}
+
+
+StreamBuffer::~StreamBuffer()
+{
+}
+
+void StreamBuffer::SetUp(GLenum aTarget, GLsizeiptr aSize)
+{
+	mTarget = aTarget;
+	mSize = aSize;
+	mUseMapRange = GLAD_GL_VERSION_3_0 != 0;
+	mUseFences = mUseMapRange && GLAD_GL_VERSION_3_2 != 0;
+
+	glGenBuffers(1, &mBufferId);
+	Orphan();
+	mOrphanCount = 0;
+}
+
+void* StreamBuffer::Map(GLsizeiptr aSize, GLintptr& aOffset)
+{
+	// a single frame wants more than the whole ring: grow it
+	if (aSize > mSize)
+	{
+		while (mSize < aSize)
+		{
+			mSize *= 2;
+		}
+		std::cerr << "StreamBuffer grown to " << mSize << " bytes\n";
+		Orphan();
+	}
+
+	mHead = (mHead + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	if (mHead + aSize > mSize)
+	{
+		// wrap around
+		if (mHead > mRangeBegin)
+		{
+			mPending.push_back({ mRangeBegin, mHead, nullptr });
+		}
+		mHead = mRangeBegin = 0;
+		if (mUseFences)
+		{
+			WaitForRange(0, aSize);
+		}
+		else
+		{
+			Orphan();
+		}
+	}
+	else if (mUseFences)
+	{
+		WaitForRange(mHead, mHead + aSize);
+	}
+
+	GLStateCache::Get().BindBuffer(mTarget, mBufferId);
+	mMappedOffset = aOffset = mHead;
+	mMappedSize = aSize;
+	mHead += aSize;
+	mCurrentFrameBytes += aSize;
+	mTotalBytes += aSize;
+
+	if (mUseMapRange)
+	{
+		return glMapBufferRange(mTarget, mMappedOffset, mMappedSize,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	mStaging.resize(static_cast<size_t>(aSize));
+	return mStaging.data();
+}
+
+void StreamBuffer::Unmap()
+{
+	if (mUseMapRange)
+	{
+		glUnmapBuffer(mTarget);
+	}
+	else
+	{
+		glBufferSubData(mTarget, mMappedOffset, mMappedSize, mStaging.data());
+	}
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (mHead > mRangeBegin)
+	{
+		mPending.push_back({ mRangeBegin, mHead, nullptr });
+	}
+	mRangeBegin = mHead;
+
+	if (mUseFences)
+	{
+		for (auto& range : mPending)
+		{
+			range.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			mFenced.push_back(range);
+		}
+	}
+	mPending.clear();
+
+	mFrameBytes = mCurrentFrameBytes;
+	mCurrentFrameBytes = 0;
+}
+
+void StreamBuffer::Orphan()
+{
+	GLStateCache::Get().BindBuffer(mTarget, mBufferId);
+	glBufferData(mTarget, mSize, nullptr, GL_STREAM_DRAW);
+
+	for (auto& range : mFenced)
+	{
+		glDeleteSync(range.sync);
+	}
+	mFenced.clear();
+	mPending.clear();
+	mHead = mRangeBegin = 0;
+	mOrphanCount++;
+}
+
+void StreamBuffer::WaitForRange(GLintptr aBegin, GLintptr aEnd)
+{
+	// data of the current frame is not fenced yet, so it can't be waited on
+	for (const auto& range : mPending)
+	{
+		if (range.begin < aEnd && aBegin < range.end)
+		{
+			Orphan();
+			return;
+		}
+	}
+
+	// the GPU retires fences in order, so waiting on the newest
+	// overlapping one releases every older range too
+	int newest = -1;
+	for (size_t i = 0; i < mFenced.size(); i++)
+	{
+		if (mFenced[i].begin < aEnd && aBegin < mFenced[i].end)
+		{
+			newest = static_cast<int>(i);
+		}
+	}
+	if (newest < 0)
+	{
+		return;
+	}
+
+	GLenum result = glClientWaitSync(mFenced[newest].sync, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		mWaitCount++;
+		do
+		{
+			result = glClientWaitSync(mFenced[newest].sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+
+	for (int i = 0; i <= newest; i++)
+	{
+		glDeleteSync(mFenced[i].sync);
+	}
+	mFenced.erase(mFenced.begin(), mFenced.begin() + newest + 1);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <vector>
+
+// Large buffer object used as a ring for data rewritten every frame.
+// Writes go to unused parts of the ring without synchronizing; fences
+// (GL 3.2) guard regions the GPU may still read, otherwise the storage
+// is orphaned when the ring wraps.
+class StreamBuffer
+{
+public:
+	static constexpr GLsizeiptr ALIGNMENT = 16;
+
+	StreamBuffer();
+	~StreamBuffer();
+	void SetUp(GLenum aTarget, GLsizeiptr aSize);
+
+	// reserves aSize bytes, binds the buffer and returns a write pointer.
+	// aOffset receives the byte offset to source the data from.
+	void* Map(GLsizeiptr aSize, GLintptr& aOffset);
+	void Unmap();
+	// fences everything written since the last call; call after the draws
+	void EndFrame();
+
+	GLuint GetId() const { return mBufferId; }
+
+	// upload statistics
+	size_t mFrameBytes; // bytes written during the last finished frame
+	size_t mTotalBytes;
+	int mOrphanCount;
+	int mWaitCount;
+
+private:
+	struct Range
+	{
+		GLintptr begin;
+		GLintptr end;
+		GLsync sync;
+	};
+
+	void Orphan();
+	void WaitForRange(GLintptr aBegin, GLintptr aEnd);
+
+	GLenum mTarget;
+	GLuint mBufferId;
+	GLsizeiptr mSize;
+	GLintptr mHead;
+	GLintptr mRangeBegin;
+	GLintptr mMappedOffset;
+	GLsizeiptr mMappedSize;
+	bool mUseMapRange;
+	bool mUseFences;
+	size_t mCurrentFrameBytes;
+	std::vector<Range> mPending; // written this frame, not fenced yet
+	std::vector<Range> mFenced;  // oldest first
+	std::vector<char> mStaging;  // used when glMapBufferRange is unavailable
+};
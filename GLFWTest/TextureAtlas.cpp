@@ -0,0 +1,231 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "GLStateCache.h"
+#include "TextureAtlas.h"
+
+
+
+TextureAtlas::TextureAtlas()
+	: mTextureId(0)
+	, mWidth(0)
+	, mHeight(0)
+{
+}
+
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+int TextureAtlas::Add(const Image& aImage)
+{
+	if (aImage.width <= 0 || aImage.height <= 0)
+	{
+		std::cerr << "TextureAtlas: cannot add an empty image\n";
+		return -1;
+	}
+	mEntries.push_back({ &aImage, 0, 0, { 0, 0, 1, 1 } });
+	return static_cast<int>(mEntries.size()) - 1;
+}
+
+bool TextureAtlas::Build(bool aUpload)
+{
+	// start from the smallest power of two that could hold the total area
+	int area = 0;
+	int widest = 0;
+	for (const auto& entry : mEntries)
+	{
+		// the image may have changed since Add()
+		if (entry.image->width <= 0 || entry.image->height <= 0)
+		{
+			std::cerr << "TextureAtlas: cannot pack an empty image\n";
+			return false;
+		}
+		area += (entry.image->width + PADDING * 2) * (entry.image->height + PADDING * 2);
+		widest = std::max(widest, entry.image->width + PADDING * 2);
+	}
+	int width = 1, height = 1;
+	while (width < widest) width *= 2;
+	while (width * height < area)
+	{
+		if (height < width) height *= 2;
+		else width *= 2;
+	}
+
+	while (!Pack(width, height))
+	{
+		if (width > height) height *= 2;
+		else width *= 2;
+
+		if (width > MAX_SIZE || height > MAX_SIZE)
+		{
+			std::cerr << "TextureAtlas: images do not fit in " << MAX_SIZE << "x" << MAX_SIZE << "\n";
+			return false;
+		}
+	}
+	mWidth = width;
+	mHeight = height;
+
+	mImage.width = mWidth;
+	mImage.height = mHeight;
+	mImage.pixels.assign(mWidth * mHeight * 3, 0);
+	for (auto& entry : mEntries)
+	{
+		Blit(entry);
+		entry.uv.u0 = static_cast<float>(entry.x) / mWidth;
+		entry.uv.v0 = static_cast<float>(entry.y) / mHeight;
+		entry.uv.u1 = static_cast<float>(entry.x + entry.image->width) / mWidth;
+		entry.uv.v1 = static_cast<float>(entry.y + entry.image->height) / mHeight;
+	}
+
+	if (!aUpload)
+	{
+		return true;
+	}
+
+	if (mTextureId == 0)
+	{
+		glGenTextures(1, &mTextureId);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLStateCache::Get().BindTexture(0, mTextureId);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, mWidth, mHeight, 0, GL_BGR, GL_UNSIGNED_BYTE, mImage.pixels.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GLStateCache::Get().BindTexture(0, 0);
+
+	return true;
+}
+
+bool TextureAtlas::Pack(int aWidth, int aHeight)
+{
+	mSkyline.clear();
+	mSkyline.push_back({ 0, 0, aWidth });
+
+	// tallest first packs noticeably tighter with a skyline
+	std::vector<size_t> order(mEntries.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		return mEntries[a].image->height > mEntries[b].image->height;
+	});
+
+	for (auto index : order)
+	{
+		auto& entry = mEntries[index];
+		const int width = entry.image->width + PADDING * 2;
+		const int height = entry.image->height + PADDING * 2;
+
+		int x, y;
+		const int node = FindPosition(width, height, x, y);
+		if (node < 0 || y + height > aHeight)
+		{
+			return false;
+		}
+		Place(node, x, y, width, height);
+		entry.x = x + PADDING;
+		entry.y = y + PADDING;
+	}
+
+	return true;
+}
+
+// bottom-left rule: lowest resulting top edge, then the narrowest segment
+int TextureAtlas::FindPosition(int aWidth, int aHeight, int& aX, int& aY) const
+{
+	int bestNode = -1;
+	int bestTop = std::numeric_limits<int>::max();
+	int bestWidth = std::numeric_limits<int>::max();
+
+	for (size_t i = 0; i < mSkyline.size(); i++)
+	{
+		const int x = mSkyline[i].x;
+		if (x + aWidth > mSkyline.back().x + mSkyline.back().width)
+		{
+			break;
+		}
+
+		// the rect rests on the highest node it spans
+		int y = 0;
+		int remaining = aWidth;
+		for (size_t j = i; remaining > 0; j++)
+		{
+			y = std::max(y, mSkyline[j].y);
+			remaining -= mSkyline[j].width;
+		}
+
+		if (y + aHeight < bestTop || (y + aHeight == bestTop && mSkyline[i].width < bestWidth))
+		{
+			bestNode = static_cast<int>(i);
+			bestTop = y + aHeight;
+			bestWidth = mSkyline[i].width;
+			aX = x;
+			aY = y;
+		}
+	}
+
+	return bestNode;
+}
+
+void TextureAtlas::Place(int aNodeIndex, int aX, int aY, int aWidth, int aHeight)
+{
+	mSkyline.insert(mSkyline.begin() + aNodeIndex, { aX, aY + aHeight, aWidth });
+
+	// shrink or drop the nodes now covered by the new one
+	for (size_t i = aNodeIndex + 1; i < mSkyline.size(); )
+	{
+		const int right = mSkyline[i - 1].x + mSkyline[i - 1].width;
+		if (mSkyline[i].x >= right)
+		{
+			break;
+		}
+		const int shrink = right - mSkyline[i].x;
+		mSkyline[i].x += shrink;
+		mSkyline[i].width -= shrink;
+		if (mSkyline[i].width > 0)
+		{
+			break;
+		}
+		mSkyline.erase(mSkyline.begin() + i);
+	}
+
+	// merge neighbours at the same height
+	for (size_t i = 0; i + 1 < mSkyline.size(); )
+	{
+		if (mSkyline[i].y == mSkyline[i + 1].y)
+		{
+			mSkyline[i].width += mSkyline[i + 1].width;
+			mSkyline.erase(mSkyline.begin() + i + 1);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+// copies the image and extrudes its edge pixels into the padding
+void TextureAtlas::Blit(const Entry& aEntry)
+{
+	const Image& image = *aEntry.image;
+	for (int y = -PADDING; y < image.height + PADDING; y++)
+	{
+		const int srcY = std::min(std::max(y, 0), image.height - 1);
+		for (int x = -PADDING; x < image.width + PADDING; x++)
+		{
+			const int srcX = std::min(std::max(x, 0), image.width - 1);
+			const unsigned char* src = &image.pixels[(srcY * image.width + srcX) * 3];
+			unsigned char* dst = &mImage.pixels[((aEntry.y + y) * mWidth + aEntry.x + x) * 3];
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <vector>
+#include "Image.h"
+
+// sub-rectangle of a texture in uv space
+struct UvRect
+{
+	float u0, v0;
+	float u1, v1;
+};
+
+// aInner given relative to aOuter (0..1 covers aOuter)
+inline UvRect SubRect(const UvRect& aOuter, const UvRect& aInner)
+{
+	const float width = aOuter.u1 - aOuter.u0;
+	const float height = aOuter.v1 - aOuter.v0;
+	return{ aOuter.u0 + aInner.u0 * width, aOuter.v0 + aInner.v0 * height,
+		aOuter.u0 + aInner.u1 * width, aOuter.v0 + aInner.v1 * height };
+}
+
+// Packs images into one power-of-two texture with a skyline packer.
+// Every image is surrounded by a border of its own edge pixels so that
+// neighbours never bleed into each other.
+class TextureAtlas
+{
+public:
+	static constexpr int PADDING = 2;
+	static constexpr int MAX_SIZE = 4096;
+
+	TextureAtlas();
+	~TextureAtlas();
+
+	// returns the index to query the uv rect with after Build(), or -1 for
+	// an image without pixels. aImage must live until Build().
+	int Add(const Image& aImage);
+	// aUpload false only packs, for the software rasterizer
+	bool Build(bool aUpload = true);
+
+	const UvRect& GetUv(int aIndex) const { return mEntries[aIndex].uv; }
+	GLuint GetTextureId() const { return mTextureId; }
+	int GetWidth() const { return mWidth; }
+	int GetHeight() const { return mHeight; }
+	// the packed pixels, valid after Build()
+	const Image& GetImage() const { return mImage; }
+
+private:
+	struct Entry
+	{
+		const Image* image;
+		int x, y;
+		UvRect uv;
+	};
+
+	struct SkylineNode
+	{
+		int x, y, width;
+	};
+
+	bool Pack(int aWidth, int aHeight);
+	int FindPosition(int aWidth, int aHeight, int& aX, int& aY) const;
+	void Place(int aNodeIndex, int aX, int aY, int aWidth, int aHeight);
+	void Blit(const Entry& aEntry);
+
+	std::vector<Entry> mEntries;
+	std::vector<SkylineNode> mSkyline;
+	Image mImage;
+	GLuint mTextureId;
+	int mWidth;
+	int mHeight;
+};
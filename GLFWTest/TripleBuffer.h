@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer.
+// The producer fills GetBack() and calls Publish(); the consumer calls
+// Update() and reads GetFront(). Neither side ever waits for the other,
+// the consumer just sees the most recently published value.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: mBack(0)
+		, mFront(1)
+		, mMiddle(2)
+	{
+	}
+
+	// only while neither side is running
+	void Reset(const T& aValue)
+	{
+		for (auto& slot : mSlots)
+		{
+			slot = aValue;
+		}
+		mMiddle = 2;
+	}
+
+	T& GetBack() { return mSlots[mBack]; }
+
+	void Publish()
+	{
+		mBack = mMiddle.exchange(mBack | DIRTY) & INDEX_MASK;
+	}
+
+	// takes the newest published value, returns false if there was none
+	bool Update()
+	{
+		if ((mMiddle.load() & DIRTY) == 0)
+		{
+			return false;
+		}
+		mFront = mMiddle.exchange(mFront) & INDEX_MASK;
+		return true;
+	}
+
+	const T& GetFront() const { return mSlots[mFront]; }
+
+private:
+	static constexpr int INDEX_MASK = 3;
+	static constexpr int DIRTY = 4;
+
+	T mSlots[3];
+	int mBack;
+	int mFront;
+	std::atomic<int> mMiddle; // index | DIRTY once published
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+struct Vec2
+{
+	float x, y;
+
+public:
+	Vec2() = default;
+
+	Vec2(float a, float b)
+		: x(a)
+		, y(b)
+	{
+	}
+
+	Vec2 operator*(float a)
+	{
+		return{ x * a, y * a };
+	}
+};
+
+// a at aT = 0, exactly b at aT = 1
+inline Vec2 Lerp(const Vec2& a, const Vec2& b, float aT)
+{
+	return{ a.x * (1 - aT) + b.x * aT, a.y * (1 - aT) + b.y * aT };
+}
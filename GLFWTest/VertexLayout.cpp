@@ -0,0 +1,142 @@
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "VertexLayout.h"
+
+
+
+namespace
+{
+	int TypeSize(GLenum aType)
+	{
+		switch (aType)
+		{
+		case GL_HALF_FLOAT:
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+			return 2;
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		default:
+			return 4;
+		}
+	}
+
+	template <typename T>
+	void Store(void* aDestination, T aValue)
+	{
+		std::memcpy(aDestination, &aValue, sizeof(T));
+	}
+}
+
+
+
+VertexLayout::VertexLayout()
+	: mStride(0)
+{
+}
+
+
+VertexLayout::~VertexLayout()
+{
+}
+
+VertexLayout& VertexLayout::Add(const char* aName, GLuint aLocation, GLint aComponents, GLenum aType, bool aNormalized)
+{
+	mAttributes.push_back({ aName, aLocation, aComponents, aType, aNormalized, mStride });
+	const int size = aComponents * TypeSize(aType);
+	mStride += (size + 3) & ~3;
+	return *this;
+}
+
+void VertexLayout::BindLocations(GLuint aProgramId) const
+{
+	for (const auto& attribute : mAttributes)
+	{
+		glBindAttribLocation(aProgramId, attribute.location, attribute.name);
+	}
+}
+
+void VertexLayout::Apply(GLintptr aBaseOffset) const
+{
+	for (const auto& attribute : mAttributes)
+	{
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized,
+			mStride, (void*)(aBaseOffset + attribute.offset));
+	}
+}
+
+void VertexLayout::Pack(int aAttribute, const float* aValues, void* aVertex) const
+{
+	const VertexAttribute& attribute = mAttributes[aAttribute];
+	unsigned char* destination = static_cast<unsigned char*>(aVertex) + attribute.offset;
+	for (int i = 0; i < attribute.components; i++)
+	{
+		const float value = aValues[i];
+		switch (attribute.type)
+		{
+		case GL_HALF_FLOAT:
+			Store(destination + i * 2, PackHalf(value));
+			break;
+		case GL_SHORT:
+			Store(destination + i * 2, static_cast<int16_t>(attribute.normalized
+				? std::lround(std::min(std::max(value, -1.f), 1.f) * 32767.f) : std::lround(value)));
+			break;
+		case GL_UNSIGNED_SHORT:
+			Store(destination + i * 2, static_cast<uint16_t>(attribute.normalized
+				? std::lround(std::min(std::max(value, 0.f), 1.f) * 65535.f) : std::lround(value)));
+			break;
+		case GL_UNSIGNED_BYTE:
+			Store(destination + i, static_cast<uint8_t>(attribute.normalized
+				? std::lround(std::min(std::max(value, 0.f), 1.f) * 255.f) : std::lround(value)));
+			break;
+		default:
+			Store(destination + i * 4, value);
+			break;
+		}
+	}
+}
+
+// round to nearest; overflow becomes infinity, tiny values flush to zero
+uint16_t PackHalf(float aValue)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &aValue, sizeof(bits));
+	const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF)
+	{
+		// inf stays inf, nan stays nan
+		return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+	}
+	if (exponent >= 31)
+	{
+		return sign | 0x7C00;
+	}
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return sign;
+		}
+		// subnormal half
+		mantissa |= 0x800000;
+		const int shift = 14 - exponent;
+		const uint32_t half = mantissa >> shift;
+		const uint32_t rest = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		return sign | static_cast<uint16_t>(half + (rest > halfway || (rest == halfway && (half & 1))));
+	}
+
+	uint32_t half = (exponent << 10) | (mantissa >> 13);
+	const uint32_t rest = mantissa & 0x1FFF;
+	// a carry into the exponent is still the right result
+	half += rest > 0x1000 || (rest == 0x1000 && (half & 1));
+	return sign | static_cast<uint16_t>(half);
+}
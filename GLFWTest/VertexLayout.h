@@ -0,0 +1,50 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <cstdint>
+#include <vector>
+
+struct VertexAttribute
+{
+	const char* name;
+	GLuint location;
+	GLint components;
+	GLenum type; // GL_FLOAT, GL_HALF_FLOAT, GL_SHORT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE
+	bool normalized;
+	int offset;
+};
+
+// Describes one interleaved vertex (or instance) of a buffer: which
+// attribute lives where and in which format. The same description binds
+// the attribute locations of a program, sets the attribute pointers and
+// packs float data into the buffer.
+//
+// Normalized GL_SHORT covers -1..1 and GL_UNSIGNED_SHORT / GL_UNSIGNED_BYTE
+// 0..1, values outside are clamped when packing. Before GL 4.2 a signed
+// normalized 0 comes out as 1/65535, far below a pixel for positions.
+// GL_HALF_FLOAT needs GL 3.0.
+class VertexLayout
+{
+public:
+	VertexLayout();
+	~VertexLayout();
+
+	// attributes are laid out in the order they are added, 4 byte aligned
+	VertexLayout& Add(const char* aName, GLuint aLocation, GLint aComponents, GLenum aType, bool aNormalized);
+
+	// before glLinkProgram
+	void BindLocations(GLuint aProgramId) const;
+	// enables and points every attribute at the bound GL_ARRAY_BUFFER
+	void Apply(GLintptr aBaseOffset = 0) const;
+	// converts aValues (one float per component) into the attribute's format
+	void Pack(int aAttribute, const float* aValues, void* aVertex) const;
+
+	const std::vector<VertexAttribute>& GetAttributes() const { return mAttributes; }
+	int GetStride() const { return mStride; }
+
+private:
+	std::vector<VertexAttribute> mAttributes;
+	int mStride;
+};
+
+uint16_t PackHalf(float aValue);
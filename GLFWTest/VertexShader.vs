@@ -1,14 +1,28 @@
-
-R"delimiter(
+// sprite vertex shader, see Shader.cpp for the defines put in front
 uniform mat4 MVP;
-attribute vec3 vCol;
-attribute vec2 vPos;
-varying vec3 color;
+attribute vec2 position;
+attribute vec2 uv;
+// per object: instanced arrays or constant attribute values
+attribute vec4 transform; // xy: position, zw: scale
+attribute vec4 uvRect;
+attribute vec4 tint;
+attribute float rotation;
+varying vec2 vuv;
+varying vec4 vtint;
+#ifdef CIRCLE
+varying vec2 vlocal;
+#endif
 
-void main()
+void main(void)
 {
-	gl_Position = MVP * vec4(vPos, 0.0, 1.0);
-	color = vCol;
+	vec2 local = position * transform.zw;
+	float c = cos(rotation);
+	float s = sin(rotation);
+	vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + transform.xy;
+	gl_Position = MVP * vec4(world, 0.0, 1.0);
+	vuv = mix(uvRect.xy, uvRect.zw, uv);
+	vtint = tint;
+#ifdef CIRCLE
+	vlocal = uv * 2.0 - 1.0;
+#endif
 }
-)delimiter"
-
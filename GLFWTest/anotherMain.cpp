@@ -5,38 +5,41 @@
 #include <vector>
 #include <numeric>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "linmath.h"
+#include "Camera.h"
+#include "FileWatcher.h"
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "Mesh.h"
+#include "PongWorld.h"
+#include "RenderTarget.h"
 #include "Shader.h"
+#include "ShaderManager.h"
+#include "SoftwareRasterizer.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "TripleBuffer.h"
+#include "Vec2.h"
 
 #undef min
 #undef max
 
 //using namespace std;
-struct Vec2
-{
-	float x, y;
-
-public:
-	Vec2() = default;
-
-	Vec2(float a, float b)
-		: x(a)
-		, y(b)
-	{
-	}
-
-	Vec2 operator*(float a)
-	{
-		return{ x * a, y * a };
-	}
-};
 
 static constexpr float PI = 3.14159265358f;
 static Vec2 WINDOW_SIZE = { 640.f, 480.f };
-static float ASPECT_RATIO = WINDOW_SIZE.x / WINDOW_SIZE.y;
-static Vec2 BAR_SIZE = { 0.1f, 0.5f };
+static Vec2 BAR_SIZE = { PongWorld::BAR_WIDTH, PongWorld::BAR_HEIGHT };
 static Vec2 NUM_SIZE = { 0.15f, 0.15f };
-static constexpr int BALL_VERTS_COUNT = 32;
+static constexpr int BALL_VERTS_COUNT = 4;
 static constexpr int BAR_VERTS_COUNT = 4;
 
 struct KeyState
@@ -63,6 +66,9 @@ public:
 };
 Input input;
 Shader shader;
+Shader circleShader(SHADER_CIRCLE);
+SpriteBatch spriteBatch;
+Camera camera;
 
 // base class for sprite object
 template<int I>
@@ -72,32 +78,24 @@ public:
 	Sprite() = default;
 	virtual ~Sprite() = default;
 
-	mat4x4 m, p, mvp;
-
-	void Draw(GLuint texId)
+	// aMesh is the GPU copy of vertex/uv, aUvRect the texture region
+	void Draw(SpriteBatch& aBatch, const Mesh& aMesh, GLuint texId, const UvRect& aUvRect)
 	{
-		mat4x4_identity(m);
-		mat4x4_translate_in_place(m, pos.x, pos.y, 0);
-		mat4x4_ortho(p, -ASPECT_RATIO, ASPECT_RATIO, -1.f, 1.f, 1.f, -1.f);
-		mat4x4_mul(mvp, p, m);
-
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glUniformMatrix4fv(shader.mMvpLocation, 1, false, (const GLfloat*)mvp);
-		// attributeo^
-		glVertexAttribPointer(shader.mPositionLocation, 2, GL_FLOAT, false, 0, geom);
-		glVertexAttribPointer(shader.mUvLocation, 2, GL_FLOAT, false, 0, uv);
-
-		// f̕`
-		glBindTexture(GL_TEXTURE_2D, texId);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, I);
+		aBatch.Draw(aMesh, texId, SubRect(aUvRect, uvRect), pos, scale, rotation, tint, layer, depth, customShader);
 	}
 
 public:
 	Vec2 size{};
 	Vec2 pos{}; // W
+	Vec2 scale{ 1.f, 1.f };
+	float rotation = 0;
+	Color tint{ 1.f, 1.f, 1.f, 1.f };
+	int layer = 0; // draw order, higher is on top
+	float depth = 0; // draw order within the layer
+	const Shader* customShader = nullptr; // nullptr: the batch's sprite shader
 	Vec2 vertex[I]{}; // offset
-	Vec2 geom[I]{}; // ۂ̒l
 	Vec2 uv[I]{}; // uv
+	UvRect uvRect{ 0, 0, 1, 1 }; // part of the texture region to use
 };
 
 template<int VertsCount = 4>
@@ -107,19 +105,18 @@ public:
 	NumTex(Vec2 aSize, Vec2 aPos)
 	{
 		static_assert(VertsCount == 4, "VertsCount == 4");
-		vertex[0] = geom[0] = { -aSize.x / 2, +aSize.y / 2 };
-		vertex[1] = geom[1] = { +aSize.x / 2, +aSize.y / 2 };
-		vertex[2] = geom[2] = { +aSize.x / 2, -aSize.y / 2 };
-		vertex[3] = geom[3] = { -aSize.x / 2, -aSize.y / 2 };
+		this->vertex[0] = { -aSize.x / 2, +aSize.y / 2 };
+		this->vertex[1] = { +aSize.x / 2, +aSize.y / 2 };
+		this->vertex[2] = { +aSize.x / 2, -aSize.y / 2 };
+		this->vertex[3] = { -aSize.x / 2, -aSize.y / 2 };
+		this->uv[0] = { 0, 1 };
+		this->uv[1] = { 1, 1 };
+		this->uv[2] = { 1, 0 };
+		this->uv[3] = { 0, 0 };
 		RefreshUv(0);
-		pos = aPos;
-		size = aSize * 0.5f;
-		// f
-		for (size_t i = 0; i < VertsCount; i++)
-		{
-			geom[i].x = pos.x + vertex[i].x;
-			geom[i].y = pos.y + vertex[i].y;
-		}
+		this->layer = 1; // HUD
+		this->pos = aPos;
+		this->size = aSize * 0.5f;
 	}
 
 	~NumTex()
@@ -132,12 +129,10 @@ public:
 		RefreshUv(aNum);
 	}
 
+	// the mesh uvs stay fixed, only the digit's part of the texture changes
 	void RefreshUv(int index)
 	{
-		uv[0] = { index       / 10.f, 1 };
-		uv[1] = { (index + 1) / 10.f, 1 };
-		uv[2] = { (index + 1) / 10.f, 0 };
-		uv[3] = { index       / 10.f, 0 };
+		this->uvRect = { index / 10.f, 0, (index + 1) / 10.f, 1 };
 	}
 
 private:
@@ -149,228 +144,233 @@ template<int VertsCount>
 class Ball : public Sprite<VertsCount>
 {
 public:
-	Ball(float aSize, float aDeg, float aSpeed)
-		: mDeg(aDeg)
-		, mSize(aSize)
-		, mSpeed(aSpeed)
-		, mMoveVec{ sin(aDeg / 180.0f * PI), cos(aDeg / 180.0f * PI) }
+	Ball(float aSize)
+		: mSize(aSize)
 	{
 		SetVertex();
-		size = { aSize , aSize };
+		this->size = { aSize , aSize };
+		this->customShader = &circleShader;
 	}
 
 	~Ball()
 	{
 	}
 
+	// ~͂ގlp` (~̌`̓VF[_ō)
 	void SetVertex()
 	{
-		for (size_t i = 0; i < VertsCount; i++)
-		{
-			vertex[i].x = cos((float)i / VertsCount * PI * 2) * mSize;
-			vertex[i].y = sin((float)i / VertsCount * PI * 2) * mSize;
-			uv[i].x = cos((float)i / VertsCount  * PI * 2) * 0.5f + 0.5f;
-			uv[i].y = sin((float)i / VertsCount  * PI * 2) * 0.5f + 0.5f;
-		}
-	}
-
-	void Move()
-	{
-		// ړ
-		pos.x += mMoveVec.x * mSpeed;
-		pos.y += mMoveVec.y * mSpeed;
-
-		const float XLimit = 0.9f;
-		const float YLimit = 0.55f;
-
-		// 
-		// X̓S[ɎĝŔ]Ȃ
-		if (pos.x > XLimit - mSize)
-		{
-			//mMoveVec.x *= -1;
-		}
-		else if (pos.x < -XLimit + mSize)
-		{
-			//mMoveVec.x *= -1;
-		}
-		if (pos.y > YLimit - mSize)
-		{
-			mMoveVec.y *= -1;
-		}
-		else if (pos.y < -YLimit + mSize)
-		{
-			mMoveVec.y *= -1;
-		}
-
-		// f
-		for (size_t i = 0; i < VertsCount; i++)
-		{
-			geom[i].x = pos.x + vertex[i].x;
-			geom[i].y = pos.y + vertex[i].y;
-		}
-	}
-
-	void SwitchX()
-	{
-		mMoveVec.x *= -1;
+		static_assert(VertsCount == 4, "VertsCount == 4");
+		this->vertex[0] = { -mSize, +mSize };
+		this->vertex[1] = { +mSize, +mSize };
+		this->vertex[2] = { +mSize, -mSize };
+		this->vertex[3] = { -mSize, -mSize };
+		this->uv[0] = { 0, 1 };
+		this->uv[1] = { 1, 1 };
+		this->uv[2] = { 1, 0 };
+		this->uv[3] = { 0, 0 };
 	}
 
 private:
-	Vec2 mMoveVec;
-	float mDeg;
 	float mSize;
-	float mSpeed;
 };
 
 template<int VertsCount>
 class Bar : public Sprite<VertsCount>
 {
 public:
-	static constexpr float MOVE_SPEED = 0.015f;
-	static constexpr float Y_LIMIT = 0.625f;
-
-public:
-	Bar(Vec2 aSize, Vec2 aPos)
-	{
-		vertex[0] = geom[0] = { -aSize.x / 2, +aSize.y / 2 };
-		vertex[1] = geom[1] = { +aSize.x / 2, +aSize.y / 2 };
-		vertex[2] = geom[2] = { +aSize.x / 2, -aSize.y / 2 };
-		vertex[3] = geom[3] = { -aSize.x / 2, -aSize.y / 2 };
-		uv[0] = { 0, 1 };
-		uv[1] = { 1, 1 };
-		uv[2] = { 1, 0 };
-		uv[3] = { 0, 0 };
-		pos = aPos;
-		size = aSize * 0.5f;
-		// f
-		for (size_t i = 0; i < VertsCount; i++)
-		{
-			geom[i].x = pos.x + vertex[i].x;
-			geom[i].y = pos.y + vertex[i].y;
-		}
-	}
-
-	~Bar()
-	{
-	}
-
-	void MoveUp()
+	Bar(Vec2 aSize)
 	{
-		Move(Vec2{ 0, +MOVE_SPEED });
+		this->vertex[0] = { -aSize.x / 2, +aSize.y / 2 };
+		this->vertex[1] = { +aSize.x / 2, +aSize.y / 2 };
+		this->vertex[2] = { +aSize.x / 2, -aSize.y / 2 };
+		this->vertex[3] = { -aSize.x / 2, -aSize.y / 2 };
+		this->uv[0] = { 0, 1 };
+		this->uv[1] = { 1, 1 };
+		this->uv[2] = { 1, 0 };
+		this->uv[3] = { 0, 0 };
+		this->size = aSize * 0.5f;
 	}
 
-	void MoveDown()
+	~Bar()
 	{
-		Move(Vec2{ 0, -MOVE_SPEED });
 	}
-
-	void Move(Vec2 aVec)
-	{
-		pos.x += aVec.x;
-		pos.y += aVec.y;
-
-		if (pos.y > Y_LIMIT - vertex[0].y)
-		{
-			pos.y = Y_LIMIT - vertex[0].y;
-		}
-		if (pos.y < -Y_LIMIT + vertex[0].y)
-		{
-			pos.y = -Y_LIMIT + vertex[0].y;
-		}
-
-		// f
-		for (size_t i = 0; i < VertsCount; i++)
-		{
-			geom[i].x = pos.x + vertex[i].x;
-			geom[i].y = pos.y + vertex[i].y;
-		}
-	}
-
-private:
-
 };
 
-auto ball = std::make_unique<Ball<BALL_VERTS_COUNT>>(0.15f, 50.0f, 0.01f);
-auto bar0 = std::make_unique<Bar<BAR_VERTS_COUNT>>(BAR_SIZE, Vec2{ -0.5f, 0.f });
-auto bar1 = std::make_unique<Bar<BAR_VERTS_COUNT>>(BAR_SIZE, Vec2{ +0.5f, 0.f });
+// {[ƃo[Ɠ_ (̂̓V~[VXbh)
+PongWorld pongWorld;
 auto leftScore = std::make_unique<NumTex<>>(NUM_SIZE, Vec2{ -0.5f, 0.4f });
 auto rightScore = std::make_unique<NumTex<>>(NUM_SIZE, Vec2{ +0.5f, 0.4f });
 
-template<int IA, int IB>
-bool IsCollidingSqSq(Sprite<IA> a, Sprite<IB> b)
-{
-	if (b.pos.x + b.size.x / 2 > a.pos.x - a.size.x / 2)
-	{
-		if (b.pos.x - b.size.x / 2 < a.pos.x + a.size.x / 2)
-		{
-			if (b.pos.y + b.size.y / 2 > a.pos.y - a.size.y / 2)
-			{
-				if (b.pos.y - b.size.y / 2 < a.pos.y + a.size.y / 2)
-				{
-					return true;
-				}
-			}
-		}
-	}
-
-	return false;
-}
-
-GLuint LoadBmp(const char* filename)
+bool ReadBmp(const char* filename, Image& aImage)
 {
 	static constexpr int bmpHeaderSize = 54;
 	char header[bmpHeaderSize];
-	// eNX`ID̐
-	GLuint id;
-	glGenTextures(1, &id);
 
 	// t@C̓ǂݍ
 	std::ifstream fstr(filename, std::ios::binary);
 	if (!fstr)
 	{
 		std::cout << "Failed to load " << filename << "\n";
-		return -1;
+		return false;
 	}
 
 	fstr.read(header, bmpHeaderSize);
 	if (header[0] != 'B' || header[1] != 'M')
 	{
 		printf("Not a correct BMP file\n");
-		return 0;
+		return false;
 	}
 	int dataPos = *(int*)&(header[0x0A]);
-	int imageSize = *(int*)&(header[0x22]);
 	int width = *(int*)&(header[0x12]);
 	int height = *(int*)&(header[0x16]);
-	if (imageSize == 0)    imageSize = width*height * 3; // 3 : one byte for each Red, Green and Blue component
 	if (dataPos == 0)      dataPos = 54; // The BMP header is done that way
+	// top-down (negative height) and empty images are not supported
+	if (width <= 0 || height <= 0)
+	{
+		std::cout << "Unsupported BMP size in " << filename << "\n";
+		return false;
+	}
+
+	// rows are padded to 4 bytes in the file but stored tightly in Image
+	const int rowSize = width * 3;
+	const int stride = (rowSize + 3) & ~3;
+	aImage.width = width;
+	aImage.height = height;
+	aImage.pixels.resize(rowSize * height);
+	fstr.seekg(dataPos, fstr.beg);
+	for (int y = 0; y < height; y++)
+	{
+		fstr.read(reinterpret_cast<char*>(&aImage.pixels[rowSize * y]), rowSize);
+		fstr.seekg(stride - rowSize, fstr.cur);
+	}
+	if (!fstr)
+	{
+		std::cout << "Failed to read pixels of " << filename << "\n";
+		return false;
+	}
 
+	return true;
+}
 
-	const size_t fileSize = static_cast<size_t>(fstr.seekg(0, fstr.end).tellg());
-	fstr.seekg(0, fstr.beg);
-	if (fileSize >= std::numeric_limits<size_t>::max())
+// BMP header fields are little-endian and not aligned
+void Put16(unsigned char* aDestination, unsigned int aValue)
+{
+	aDestination[0] = static_cast<unsigned char>(aValue);
+	aDestination[1] = static_cast<unsigned char>(aValue >> 8);
+}
+
+void Put32(unsigned char* aDestination, unsigned int aValue)
+{
+	Put16(aDestination, aValue);
+	Put16(aDestination + 2, aValue >> 16);
+}
+
+bool WriteBmp(const char* filename, const Image& aImage)
+{
+	const int rowSize = aImage.width * 3;
+	const int stride = (rowSize + 3) & ~3;
+	const int imageSize = stride * aImage.height;
+
+	unsigned char header[54] = { 'B', 'M' };
+	Put32(&header[0x02], 54 + imageSize);
+	Put32(&header[0x0A], 54);
+	Put32(&header[0x0E], 40);
+	Put32(&header[0x12], aImage.width);
+	Put32(&header[0x16], aImage.height);
+	Put16(&header[0x1A], 1);
+	Put16(&header[0x1C], 24);
+	Put32(&header[0x22], imageSize);
+
+	std::ofstream fstr(filename, std::ios::binary);
+	if (!fstr)
 	{
-		std::cout << "Failed to get filesize that must be less than size_t max";
+		std::cout << "Failed to write " << filename << "\n";
+		return false;
 	}
-	char* textureBuffer = new char[fileSize];
-	fstr.read(textureBuffer, fileSize);
+	fstr.write(reinterpret_cast<const char*>(header), sizeof(header));
+	const char padding[3] = {};
+	for (int y = 0; y < aImage.height; y++)
+	{
+		fstr.write(reinterpret_cast<const char*>(&aImage.pixels[rowSize * y]), rowSize);
+		fstr.write(padding, stride - rowSize);
+	}
+	return static_cast<bool>(fstr);
+}
 
-	// eNX`GPUɓ]
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glBindTexture(GL_TEXTURE_2D, id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, textureBuffer + bmpHeaderSize);
+// what the render thread needs from one simulation step
+struct WorldSnapshot
+{
+	Vec2 bar0Pos;
+	Vec2 bar1Pos;
+	Vec2 ballPos;
+	// before the step, the render thread interpolates from here
+	Vec2 lastBar0Pos;
+	Vec2 lastBar1Pos;
+	Vec2 lastBallPos;
+	int leftPoint;
+	int rightPoint;
+	unsigned int tick;
+	double time; // glfwGetTime() the step was due at
+};
 
-	// eNX`̐ݒ
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+static constexpr int SIMULATION_HZ = PongWorld::STEP_HZ;
+// at most this many steps per wake-up, the rest of a longer stall is dropped
+static constexpr int MAX_SIMULATION_STEPS = 5;
+// InputButton bits sampled on the GLFW thread for the simulation thread
+std::atomic<unsigned int> inputButtons{ 0 };
+std::atomic<bool> simulationRunning{ false };
+TripleBuffer<WorldSnapshot> snapshots;
 
-	// eNX`̃AoCh
-	delete[] textureBuffer;
-	glBindTexture(GL_TEXTURE_2D, 0);
+unsigned int SampleButtons()
+{
+	unsigned int buttons = 0;
+	if (input.mKeyStates[GLFW_KEY_W].pressed)    buttons |= BUTTON_LEFT_UP;
+	if (input.mKeyStates[GLFW_KEY_S].pressed)    buttons |= BUTTON_LEFT_DOWN;
+	if (input.mKeyStates[GLFW_KEY_UP].pressed)   buttons |= BUTTON_RIGHT_UP;
+	if (input.mKeyStates[GLFW_KEY_DOWN].pressed) buttons |= BUTTON_RIGHT_DOWN;
+	return buttons;
+}
 
-	return id;
+// advances pongWorld by one step and publishes a snapshot
+void StepSimulation(unsigned int buttons, double time)
+{
+	const Vec2 lastBar0Pos = pongWorld.GetBar0Pos();
+	const Vec2 lastBar1Pos = pongWorld.GetBar1Pos();
+	Vec2 lastBallPos = pongWorld.GetBallPos();
+	const int lastPoints = pongWorld.GetLeftPoint() + pongWorld.GetRightPoint();
+	pongWorld.Step({ buttons });
+	// S[͒BԂŉʂ؂点Ȃ
+	if (pongWorld.GetLeftPoint() + pongWorld.GetRightPoint() != lastPoints)
+	{
+		lastBallPos = pongWorld.GetBallPos();
+	}
+
+	snapshots.GetBack() = { pongWorld.GetBar0Pos(), pongWorld.GetBar1Pos(), pongWorld.GetBallPos(),
+		lastBar0Pos, lastBar1Pos, lastBallPos,
+		pongWorld.GetLeftPoint(), pongWorld.GetRightPoint(), pongWorld.GetTick(), time };
+	snapshots.Publish();
+}
+
+// simulation thread: owns pongWorld while running. Steps at aHz by
+// glfwGetTime(), however fast or slow the display is.
+void Simulate(int aHz)
+{
+	FixedTimestep timestep;
+	timestep.SetUp(aHz, MAX_SIMULATION_STEPS);
+	timestep.Start(glfwGetTime());
+
+	while (simulationRunning)
+	{
+		const double now = glfwGetTime();
+		const int steps = timestep.Advance(now);
+		// the time each step stands for; the last one is due a fraction of a step ago
+		const double lastStepTime = now - timestep.GetAlpha() * timestep.GetStep();
+		for (int i = 0; i < steps; i++)
+		{
+			StepSimulation(inputButtons.load(), lastStepTime - (steps - 1 - i) * timestep.GetStep());
+		}
+		std::this_thread::sleep_for(std::chrono::duration<double>((1 - timestep.GetAlpha()) * timestep.GetStep()));
+	}
 }
 
 // G[R[obN
@@ -397,8 +397,13 @@ void KeyCallback2(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, true);
 	}
 }
+#ifdef _WIN32
 #include <direct.h>
 #define GetCurrentDir _getcwd
+#else
+#include <unistd.h>
+#define GetCurrentDir getcwd
+#endif
 std::string GetCurrentWorkingDir(void)
 {
 	char buff[FILENAME_MAX];
@@ -407,113 +412,361 @@ std::string GetCurrentWorkingDir(void)
 	return current_working_dir;
 }
 
-int main()
+// R}hC
+struct Options
+{
+	bool headless = false;            // invisible window, render into an FBO
+	bool software = false;            // no window or GL, CPU rasterizer
+	int threads = 0;                  // software rasterizer threads, 0: all
+	int frames = 0;                   // 0: until the window is closed
+	const char* dumpPrefix = nullptr; // write frames to <prefix>00000.bmp...
+	int dumpInterval = 1;
+	bool profile = false;             // print CPU and GPU time per pass
+	bool uncapped = false;            // no vsync, no frame limit
+	double fps = 0;                   // > 0: no vsync, limit to this rate
+	int simulationHz = SIMULATION_HZ; // simulation steps per second
+};
+
+Options ParseOptions(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+		}
+		else if (std::strcmp(argv[i], "--software") == 0)
+		{
+			options.software = true;
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+		{
+			options.threads = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+		{
+			options.frames = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--dump") == 0 && hasValue)
+		{
+			options.dumpPrefix = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--dump-interval") == 0 && hasValue)
+		{
+			options.dumpInterval = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--profile") == 0)
+		{
+			options.profile = true;
+		}
+		else if (std::strcmp(argv[i], "--uncapped") == 0)
+		{
+			options.uncapped = true;
+		}
+		else if (std::strcmp(argv[i], "--fps") == 0 && hasValue)
+		{
+			options.fps = std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--sim-hz") == 0 && hasValue)
+		{
+			options.simulationHz = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			std::cerr << "unknown option " << argv[i] << "\n"
+				<< "usage: " << argv[0] << " [--headless | --software [--threads N]] [--frames N] [--dump PREFIX] [--dump-interval N] [--profile] [--uncapped | --fps N] [--sim-hz N]\n";
+		}
+	}
+
+	// headless runs are benchmarks, they have to end
+	if ((options.headless || options.software) && options.frames == 0)
+	{
+		options.frames = 600;
+	}
+	return options;
+}
+
+int main(int argc, char* argv[])
 {
 	std::cout << "current directory is " << GetCurrentWorkingDir().c_str() << "\n";
+	const Options options = ParseOptions(argc, argv);
+	// offscreen frames step the simulation themselves and can be dumped
+	const bool offscreen = options.headless || options.software;
 
-	if (!glfwInit())
+	// t[[g̐: vsync / Ȃ / wfps
+	FramePacer pacer;
+	if (options.fps > 0)
 	{
-		return -1;
+		pacer.SetUp(PACING_TARGET_FPS, options.fps);
+	}
+	else
+	{
+		pacer.SetUp(options.uncapped || offscreen ? PACING_UNCAPPED : PACING_VSYNC);
 	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
-	GLFWwindow* window = glfwCreateWindow(WINDOW_SIZE.x, WINDOW_SIZE.y, "Pong Game", NULL, NULL);
-	if (!window)
+	GLFWwindow* window = nullptr;
+	SoftwareRasterizer rasterizer;
+	if (options.software)
 	{
-		glfwTerminate();
-		return -1;
+		// GLFWGLgȂ
+		rasterizer.SetUp(static_cast<int>(WINDOW_SIZE.x), static_cast<int>(WINDOW_SIZE.y), options.threads);
+		spriteBatch.SetUp(rasterizer);
+		camera.Resize(static_cast<int>(WINDOW_SIZE.x), static_cast<int>(WINDOW_SIZE.y));
+		std::cout << "software rasterizer, " << rasterizer.GetThreadCount() << " threads\n";
 	}
+	else
+	{
+		if (!glfwInit())
+		{
+			return -1;
+		}
+
+		if (options.headless)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		}
+		// 3.3 brings vertex arrays and instancing, 2.0 drivers fall back to
+		// per-draw attribute setup. No profile is requested, so the old
+		// GLSL 1.10 shaders keep working.
+		const int contextVersions[][2] = { { 3, 3 }, { 2, 0 } };
+		for (const auto& version : contextVersions)
+		{
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+			window = glfwCreateWindow(WINDOW_SIZE.x, WINDOW_SIZE.y, "Pong Game", NULL, NULL);
+			if (window)
+			{
+				break;
+			}
+		}
+		if (!window)
+		{
+			glfwTerminate();
+			return -1;
+		}
 
-	glfwSetErrorCallback(ErrorCallback2);
-	glfwSetKeyCallback(window, KeyCallback2);
+		glfwSetErrorCallback(ErrorCallback2);
+		glfwSetKeyCallback(window, KeyCallback2);
+
+		// j^Ƃ̓
+		glfwMakeContextCurrent(window);
+		auto addr = (GLADloadproc)glfwGetProcAddress;
+		gladLoadGLLoader(addr);
+		std::cout << "OpenGL " << GLVersion.major << "." << GLVersion.minor << "\n";
+		// headless frames are never presented, the pacer runs them unthrottled
+		glfwSwapInterval(pacer.GetSwapInterval());
+
+		//GLuint programId = CreateShader();
+		// Nς݂̃vO̓fBXNɃLbV
+		ShaderManager::Get().SetUp("shader_cache");
+		// S̃RpCɎn߂āAXvCgp҂B
+		// {[͉~̃VF[_ł܂ŃXvCgpŕ`
+		// (headless ͖񓯂Gɂ邽ߑS҂)
+		if (!circleShader.SetUp(options.headless ? nullptr : &shader) || !shader.SetUp())
+		{
+			glfwTerminate();
+			return -1;
+		}
+		std::cout << "shaders: " << ShaderManager::Get().mLoadedCount << " cached, "
+			<< ShaderManager::Get().mCompiledCount << " compiled, "
+			<< ShaderManager::Get().GetPendingCount() << " compiling"
+			<< (ShaderManager::Get().IsParallelCompileSupported() ? " in parallel\n" : "\n");
+		// VertexShader.vs / FragmentShader.fs ۑƎsɔf
+		if (!options.headless)
+		{
+			FileWatcher::Get().Start();
+		}
+		spriteBatch.SetUp(shader);
+		camera.SetUp(window);
+	}
 
-	// j^Ƃ̓
-	glfwMakeContextCurrent(window);
-	auto addr = (GLADloadproc)glfwGetProcAddress;
-	gladLoadGLLoader(addr);
-	glfwSwapInterval(1);
+	// SẲ摜1̃eNX`ɂ܂Ƃ߂
+	Image barImage, ballImage, numImage;
+	// 摜͍ƃfBNgǂ (GLFWTest/ ŋN)
+	if (!ReadBmp("wood.bmp", barImage) || !ReadBmp("ball.bmp", ballImage) || !ReadBmp("num.bmp", numImage))
+	{
+		glfwTerminate();
+		return -1;
+	}
 
-	//GLuint programId = CreateShader();
-	shader.SetUp();
+	TextureAtlas atlas;
+	const int barIndex = atlas.Add(barImage);
+	const int ballIndex = atlas.Add(ballImage);
+	const int numIndex = atlas.Add(numImage);
+	if (!atlas.Build(!options.software))
+	{
+		glfwTerminate();
+		return -1;
+	}
+	// 0 in software mode, the rasterizer maps it to the same pixels
+	const GLuint atlasId = atlas.GetTextureId();
+	rasterizer.SetTexture(atlasId, &atlas.GetImage());
+
+	// `p̃XvCg (ʒu͖t[ pongWorld ̃XibvVbg)
+	Bar<BAR_VERTS_COUNT> barView0(BAR_SIZE);
+	Bar<BAR_VERTS_COUNT> barView1(BAR_SIZE);
+	Ball<BALL_VERTS_COUNT> ballView(PongWorld::BALL_SIZE);
+
+	// [J`͈xGPUɓ]
+	Mesh barMesh, ballMesh, numMesh;
+	barMesh.SetUp(barView0.vertex, barView0.uv, BAR_VERTS_COUNT, GL_TRIANGLE_FAN, !options.software);
+	ballMesh.SetUp(ballView.vertex, ballView.uv, BALL_VERTS_COUNT, GL_TRIANGLE_FAN, !options.software);
+	numMesh.SetUp(leftScore->vertex, leftScore->uv, 4, GL_TRIANGLE_FAN, !options.software);
+
+	RenderTarget renderTarget;
+	if (options.headless && !renderTarget.SetUp(static_cast<int>(WINDOW_SIZE.x), static_cast<int>(WINDOW_SIZE.y)))
+	{
+		glfwTerminate();
+		return -1;
+	}
+	Image frameImage;
+
+	// offscreen modes step the simulation once per frame so that frames are reproducible
+	pongWorld.SetUp(PongWorld::BALL_DEG, options.simulationHz);
+	snapshots.Reset({ pongWorld.GetBar0Pos(), pongWorld.GetBar1Pos(), pongWorld.GetBallPos(),
+		pongWorld.GetBar0Pos(), pongWorld.GetBar1Pos(), pongWorld.GetBallPos(), 0, 0, 0, 0.0 });
+	simulationRunning = !offscreen;
+	std::thread simulation;
+	if (simulationRunning)
+	{
+		simulation = std::thread(Simulate, options.simulationHz);
+	}
 
-	GLuint barId = LoadBmp("wood.bmp");
-	GLuint ballId = LoadBmp("ball.bmp");
-	GLuint numId = LoadBmp("num.bmp");
+	// ԂƂCPU/GPU (--profile)
+	GpuProfiler profiler;
+	if (options.profile)
+	{
+		profiler.SetUp(!options.software);
+	}
+	static constexpr int PROFILE_INTERVAL = 300;
 
-	int leftPoint = 0, rightPoint = 0;
+	const auto startTime = std::chrono::steady_clock::now();
+	int frame = 0;
 
 	// Q[[v
-	while (!glfwWindowShouldClose(window))
+	while ((window == nullptr || !glfwWindowShouldClose(window)) && (options.frames == 0 || frame < options.frames))
 	{
+		profiler.BeginFrame();
+		// ꂽVF[_̓t[̋ڂōւ
+		if (!options.software)
+		{
+			ShaderManager::Get().Update();
+			shader.Update();
+			circleShader.Update();
+		}
+
 		// -- vZ --
-		// o[̈ړ
-		if (input.mKeyStates[GLFW_KEY_W].pressed)
+		if (offscreen)
 		{
-			bar0->MoveUp();
+			StepSimulation(0, 0.0);
 		}
-		else if (input.mKeyStates[GLFW_KEY_S].pressed)
+		if (options.headless)
 		{
-			bar0->MoveDown();
+			renderTarget.Bind();
 		}
 
-		if (input.mKeyStates[GLFW_KEY_UP].pressed)
+		// ŐṼV~[Vʂ𔽉f
+		snapshots.Update();
+		const WorldSnapshot& world = snapshots.GetFront();
+		// O2Xebv̊ԂԂ (1Xebvxŕ\)Boffscreen ͖t[1XebvȂ̂ŕԂȂ
+		const float alpha = offscreen ? 1.f
+			: static_cast<float>(std::min(std::max((glfwGetTime() - world.time) * options.simulationHz, 0.0), 1.0));
+		barView0.pos = Lerp(world.lastBar0Pos, world.bar0Pos, alpha);
+		barView1.pos = Lerp(world.lastBar1Pos, world.bar1Pos, alpha);
+		ballView.pos = Lerp(world.lastBallPos, world.ballPos, alpha);
+		leftScore->Update(world.leftPoint);
+		rightScore->Update(world.rightPoint);
+
+		// -- ` -- 
+		// ʂ̏
+		profiler.BeginPass("clear");
+		if (options.software)
 		{
-			bar1->MoveUp();
+			rasterizer.Clear({ 0.2f, 0.2f, 0.2f, 0.0f });
 		}
-		else if (input.mKeyStates[GLFW_KEY_DOWN].pressed)
+		else
 		{
-			bar1->MoveDown();
+			glClearColor(0.2f, 0.2f, 0.2f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glClearDepth(1.0);
 		}
-
-		// {[̈ړ
-		// Wgeomւ̓KpKŌ
-		const float X_LIMIT = 0.8f;
-		if (ball->pos.x > +X_LIMIT)
+		profiler.EndPass();
+
+		profiler.BeginPass("sprites");
+		spriteBatch.Begin(camera.GetViewProj());
+		barView0.Draw(spriteBatch, barMesh, atlasId, atlas.GetUv(barIndex));
+		barView1.Draw(spriteBatch, barMesh, atlasId, atlas.GetUv(barIndex));
+		ballView.Draw(spriteBatch, ballMesh, atlasId, atlas.GetUv(ballIndex));
+		leftScore->Draw(spriteBatch, numMesh, atlasId, atlas.GetUv(numIndex));
+		rightScore->Draw(spriteBatch, numMesh, atlasId, atlas.GetUv(numIndex));
+		spriteBatch.End();
+		profiler.EndPass();
+
+		if (offscreen)
 		{
-			leftPoint++;
-			leftScore->Update(leftPoint);
-			ball->pos.x = 0;
-			ball->SwitchX();
+			if (options.dumpPrefix != nullptr && frame % options.dumpInterval == 0)
+			{
+				profiler.BeginPass("readback");
+				char filename[FILENAME_MAX];
+				std::snprintf(filename, sizeof(filename), "%s%05d.bmp", options.dumpPrefix, frame);
+				if (options.software)
+				{
+					rasterizer.ReadPixels(frameImage);
+				}
+				else
+				{
+					renderTarget.ReadPixels(frameImage);
+				}
+				profiler.EndPass();
+				WriteBmp(filename, frameImage);
+			}
 		}
-		else if (ball->pos.x < -X_LIMIT)
+		else
 		{
-			rightPoint++;
-			rightScore->Update(rightPoint);
-			ball->pos.x = 0;
-			ball->SwitchX();
+			glfwSwapBuffers(window);
 		}
-
-		ball->Move();
-		// 蔻
-		if (IsCollidingSqSq(*ball, *bar0))
+		if (window != nullptr)
 		{
-			ball->SwitchX();
-			ball->pos.x = bar0->pos.x + bar0->size.x / 2 + ball->size.x / 2;
+			glfwPollEvents();
 		}
-		if (IsCollidingSqSq(*ball, *bar1))
+		inputButtons = SampleButtons();
+		profiler.EndFrame();
+		GLStateCache::Get().EndFrame();
+		pacer.EndFrame();
+		frame++;
+		if (options.profile && frame % PROFILE_INTERVAL == 0)
 		{
-			ball->SwitchX();
-			ball->pos.x = bar1->pos.x - bar1->size.x / 2 - ball->size.x / 2;
+			profiler.Print(std::cout);
+			GLStateCache::Get().Print(std::cout);
+			pacer.Print(std::cout);
 		}
+	}
 
-
-		// -- ` -- 
-		// ʂ̏
-		glClearColor(0.2f, 0.2f, 0.2f, 0.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glClearDepth(1.0);
-
-		bar0->Draw(barId);
-		bar1->Draw(barId);
-		ball->Draw(ballId);
-		leftScore->Draw(numId);
-		rightScore->Draw(numId);
-
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	if (offscreen)
+	{
+		if (options.headless)
+		{
+			glFinish();
+		}
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		std::cout << frame << " frames in " << elapsed << " s, "
+			<< elapsed * 1000.0 / std::max(frame, 1) << " ms/frame\n";
+	}
+	if (options.profile)
+	{
+		profiler.Print(std::cout);
+		GLStateCache::Get().Print(std::cout);
 	}
+	pacer.Print(std::cout);
 
+	if (simulation.joinable())
+	{
+		simulationRunning = false;
+		simulation.join();
+	}
+	FileWatcher::Get().Stop();
 	glfwTerminate();
 
 	return 0;
@@ -7,7 +7,23 @@
 #include <GLFW/glfw3.h>
 
 #include "linmath.h"
+#include "Camera.h"
+#include "Collision.h"
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "Mesh.h"
+#include "QuadIndexBuffer.h"
+#include "Shader.h"
+#include "ShaderManager.h"
+#include "SpriteBatch.h"
+#include "StaticBuffer.h"
+#include "VertexLayout.h"
+#include <algorithm>
 #include <complex>
+#include <initializer_list>
+#include <vector>
 
 
 // this line below prevents console window to pop up
@@ -70,17 +86,29 @@ Vertex bar[4] =
 	{ +BAR_THICKNESS / 2, -BAR_HEIGHT / 2, 1.f, 0.f, 0.f },
 	{ -BAR_THICKNESS / 2, -BAR_HEIGHT / 2, 1.f, 1.f, 0.f },
 };
+// GPU int16 ̍W + RGBA8 ̐F (20oCg -> 8oCg)
+static const VertexLayout BAR_LAYOUT = VertexLayout()
+	.Add("vPos", 0, 2, GL_SHORT, true)
+	.Add("vCol", 1, 4, GL_UNSIGNED_BYTE, true);
 
-const int CIRCLE_VERTEX_DIVISION = 36;
-const int CIRCLE_VERTEX_COUNT = CIRCLE_VERTEX_DIVISION + 2; // SƍŌ̏d_
-Vertex circleVerts[CIRCLE_VERTEX_COUNT];
 GLFWwindow* window;
 
 static constexpr float BALL_SPEED = 0.02f;
 static constexpr float BALL_RADIUS = 0.1f;
+// ~1̎lp`AF̉~̓VF[_(SHADER_RAINBOW_CIRCLE)ŕ`
+Vec2 circleVerts[4] =
+{
+	{ -BALL_RADIUS, +BALL_RADIUS },
+	{ +BALL_RADIUS, +BALL_RADIUS },
+	{ +BALL_RADIUS, -BALL_RADIUS },
+	{ -BALL_RADIUS, -BALL_RADIUS },
+};
+Vec2 circleUvs[4] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
 static constexpr float BALL_LIMIT = 1.0f - BALL_RADIUS;
 static constexpr float X_LIMIT = 1.4f;
 static constexpr float SPEED = 0.02f;
+// SPEED  BALL_SPEED 1XebvB\̃t[[gɊ֌WȂ̑Ői߂
+static constexpr int STEP_HZ = 60;
 static constexpr float START_DIR = 2 * PI * 0.7f;
 Extent bar0;
 Extent bar1;
@@ -117,12 +145,6 @@ void main()
 GLuint loadBMP_custom(const char * imagepath);
 
 
-// CfbNXɉĐFp̒l擾
-float GetColorValue(int index, int maxCount, int offset)
-{
-	return max((fabs((((index + offset) % maxCount) * 2.0f / maxCount) - 1.0f) * 3.0f) - 1.0f, 0);
-}
-
 // _W̐ݒ
 void SetVertices()
 {
@@ -135,19 +157,6 @@ void SetVertices()
 	// circle
 	ball.x = ball.y = 0;
 	ball.width = ball.height = BALL_RADIUS * 2;
-	circleVerts[0].x = 0;
-	circleVerts[0].y = 0;
-	circleVerts[0].r = 1.0f;
-	circleVerts[0].g = 1.0f;
-	circleVerts[0].b = 1.0f;
-	for (int i = 0; i <= CIRCLE_VERTEX_DIVISION; i++)
-	{
-		circleVerts[i + 1].x = cos(PI * 2 / CIRCLE_VERTEX_DIVISION * i) * BALL_RADIUS;
-		circleVerts[i + 1].y = sin(PI * 2 / CIRCLE_VERTEX_DIVISION * i) * BALL_RADIUS;
-		circleVerts[i + 1].r = GetColorValue(i, CIRCLE_VERTEX_DIVISION, CIRCLE_VERTEX_DIVISION / 3 * 0);
-		circleVerts[i + 1].g = GetColorValue(i, CIRCLE_VERTEX_DIVISION, CIRCLE_VERTEX_DIVISION / 3 * 1);
-		circleVerts[i + 1].b = GetColorValue(i, CIRCLE_VERTEX_DIVISION, CIRCLE_VERTEX_DIVISION / 3 * 2);
-	}
 }
 
 // G[R[obN
@@ -170,26 +179,6 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	}
 }
 
-// 
-bool IsCollidingSqSq(const Extent& a, const Extent& b)
-{
-	if (a.x - a.width / 2 > b.x - b.width / 2 - a.width)
-	{
-		if (a.x - a.width / 2 < b.x + b.width / 2)
-		{
-			if (a.y - a.height / 2 > b.y - b.height / 2 - a.height)
-			{
-				if (a.y - a.height / 2 < b.y + b.height / 2)
-				{
-					return true;
-				}
-			}
-		}
-	}
-
-	return false;
-}
-
 // ̓}Ct[
 void ProcessInputs()
 {
@@ -202,7 +191,7 @@ void ProcessInputs()
 	{
 		bar0.y -= SPEED;
 	}
-	bar0.y = max(-BAR_LIMIT, min(bar0.y, BAR_LIMIT));
+	bar0.y = std::max(-BAR_LIMIT, std::min(bar0.y, BAR_LIMIT));
 
 	// E
 	if (input.mKeyStates[GLFW_KEY_UP].pressed)
@@ -213,7 +202,7 @@ void ProcessInputs()
 	{
 		bar1.y -= SPEED;
 	}
-	bar1.y = max(-BAR_LIMIT, min(bar1.y, BAR_LIMIT));
+	bar1.y = std::max(-BAR_LIMIT, std::min(bar1.y, BAR_LIMIT));
 
 	// I
 	if (input.mKeyStates[GLFW_KEY_ESCAPE].pressed)
@@ -224,55 +213,47 @@ void ProcessInputs()
 
 void UpdateBall()
 {
-	// o[ɓ甽
-	if (IsCollidingSqSq(ball, bar0))
+	// ǂŔ
+	if (ball.x < -X_LIMIT || ball.x > X_LIMIT)
 	{
-		if (ball.x > bar0.x)
-		{
-			dir[0] *= -1;
-			ball.x = bar0.x + bar0.width / 2 + ball.width / 2;
-		}
-		else
-		{
-			ball.x = bar0.x - bar0.width / 2 - ball.width / 2;
-		}
+		dir[0] *= -1;
 	}
-	if (IsCollidingSqSq(ball, bar1))
+	if (ball.y < -BALL_LIMIT || ball.y > BALL_LIMIT)
 	{
-		if (ball.x < bar1.x)
-		{
-			dir[0] *= -1;
-			ball.x = bar1.x - bar1.width / 2 - ball.width / 2;
-		}
-		else
-		{
-			ball.x = bar1.x + bar1.width / 2 + ball.width / 2;
-		}
+		dir[1] *= -1;
 	}
 
-
-	// 
-	else if (ball.x < -X_LIMIT)
+	// ̈ړŃo[ɓ邩AԑڐGT
+	const Vec2 start = { ball.x, ball.y };
+	const Vec2 motion = { dir[0] * BALL_SPEED, dir[1] * BALL_SPEED };
+	SweepHit first;
+	bool hit = false;
+	for (const Extent* bar : { &bar0, &bar1 })
 	{
-		dir[0] *= -1;
-	}
-	else if (ball.x > X_LIMIT)
-	{
-		dir[0] *= -1;
+		SweepHit barHit;
+		if (SweepCircleBox(start, motion, ball.width / 2, { bar->x, bar->y },
+			{ bar->width / 2, bar->height / 2 }, barHit) && (!hit || barHit.time < first.time))
+		{
+			first = barHit;
+			hit = true;
+		}
 	}
-	else if (ball.y < -BALL_LIMIT)
+
+	// ړ ڐG_Ŗ@ɉĔ˂Ac̋i
+	if (hit)
 	{
-		dir[1] *= -1;
+		const Vec2 reflected = Reflect({ dir[0], dir[1] }, first.normal);
+		dir[0] = reflected.x;
+		dir[1] = reflected.y;
+		ball.x = first.position.x + dir[0] * BALL_SPEED * (1 - first.time);
+		ball.y = first.position.y + dir[1] * BALL_SPEED * (1 - first.time);
 	}
-	else if (ball.y > BALL_LIMIT)
+	else
 	{
-		dir[1] *= -1;
+		ball.x += motion.x;
+		ball.y += motion.y;
 	}
 
-	// ړ
-	ball.x += dir[0] * BALL_SPEED;
-	ball.y += dir[1] * BALL_SPEED;
-
 	// [ɍsĂ^񒆂烊X|[
 	if (ball.x > X_LIMIT)
 	{
@@ -340,7 +321,7 @@ GLuint InitTexture(const char* path)
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 	/* eNX`̊蓖 */
-	glBindTexture(GL_TEXTURE_2D, texId);
+	GLStateCache::Get().BindTexture(0, texId);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEXWIDTH, TEXHEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, texture);
 
 	/* eNX`gEk@̎w */
@@ -384,7 +365,7 @@ void Scene()
 	glTexCoordPointer(2, GL_FLOAT, 0, texuv);
 
 	// Step6. eNX`̉摜w
-	glBindTexture(GL_TEXTURE_2D, texId);
+	GLStateCache::Get().BindTexture(0, texId);
 
 	// Step7. eNX`̕`
 	glEnable(GL_TEXTURE_2D);
@@ -420,10 +401,14 @@ void Scene()
 // ENTRY POINT
 int main_()
 {
-	static const int VERTEX_BUFFER_COUNT = 4;
-	GLuint vertexBuffers[VERTEX_BUFFER_COUNT];
-	GLuint vertexShader, fragmentShader, program;
-	GLint mvpLocation, vposLocation, vcolLocation;
+	StaticBuffer barBuffer;
+	GLuint barVertexArray = 0;
+	Shader circleShader(SHADER_RAINBOW_CIRCLE);
+	Mesh circleMesh;
+	SpriteBatch circleBatch;
+	Camera camera;
+	GLuint program;
+	GLint mvpLocation;
 
 
 	if (!glfwInit())
@@ -432,12 +417,21 @@ int main_()
 		return 1;
 	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 	//glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
 	//glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-	window = glfwCreateWindow(640, 480, "sample", nullptr, nullptr);
+	// 3.3 for vertex arrays, 2.0 if the driver has nothing newer
+	const int contextVersions[][2] = { { 3, 3 }, { 2, 0 } };
+	for (const auto& version : contextVersions)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+		window = glfwCreateWindow(640, 480, "sample", nullptr, nullptr);
+		if (window != nullptr)
+		{
+			break;
+		}
+	}
 	if (window == nullptr)
 	{
 		std::cerr << "Failed to create GLFW window\n";
@@ -458,30 +452,54 @@ int main_()
 	auto addr = (GLADloadproc)glfwGetProcAddress;
 	
 	gladLoadGLLoader(addr);
-	glfwSwapInterval(1);
+	FramePacer pacer;
+	pacer.SetUp(PACING_VSYNC);
+	glfwSwapInterval(pacer.GetSwapInterval());
+	camera.SetUp(window);
 
 	// NOTE: OpenGL error checks has been omitted for brevity
-	glGenBuffers(VERTEX_BUFFER_COUNT, vertexBuffers);
+	// the meshes never change, so they are uploaded once
+	std::vector<unsigned char> barData(BAR_LAYOUT.GetStride() * 4);
+	for (int i = 0; i < 4; i++)
+	{
+		const float color[4] = { bar[i].r, bar[i].g, bar[i].b, 1.f };
+		BAR_LAYOUT.Pack(0, &bar[i].x, &barData[i * BAR_LAYOUT.GetStride()]);
+		BAR_LAYOUT.Pack(1, color, &barData[i * BAR_LAYOUT.GetStride()]);
+	}
+	barBuffer.SetUp(GL_ARRAY_BUFFER, barData.data(), barData.size());
+	// o[͋LCfbNXobt@ GL_TRIANGLES Ƃĕ`
+	QuadIndexBuffer::Get().Reserve(1);
+	circleMesh.SetUp(circleVerts, circleUvs, 4);
+	ShaderManager::Get().SetUp("shader_cache");
+	circleShader.SetUp();
+	circleBatch.SetUp(circleShader);
 
 	// set shader 
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &VERTEX_SHADER_TEXT, nullptr);
-	glCompileShader(vertexShader);
-
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &FRAGMENT_SHADER_TEXT, nullptr);
-	glCompileShader(fragmentShader);
-
-	program = glCreateProgram();
-	glAttachShader(program, vertexShader);
-	glAttachShader(program, fragmentShader);
-	glLinkProgram(program);
+	program = ShaderManager::Get().CreateProgram("bar", VERTEX_SHADER_TEXT, FRAGMENT_SHADER_TEXT, { &BAR_LAYOUT });
+	if (program == 0)
+	{
+		glfwTerminate();
+		return 1;
+	}
 
 	mvpLocation = glGetUniformLocation(program, "MVP");
-	vposLocation = glGetAttribLocation(program, "vPos");
-	vcolLocation = glGetAttribLocation(program, "vCol");
 
-	glUseProgram(program);
+	GLStateCache::Get().UseProgram(program);
+
+	// records the bar's attribute setup once; 2.x contexts redo it per draw
+	auto setUpBarAttributes = [&]()
+	{
+		barBuffer.Bind();
+		BAR_LAYOUT.Apply();
+		QuadIndexBuffer::Get().Bind();
+	};
+	if (GLAD_GL_VERSION_3_0)
+	{
+		glGenVertexArrays(1, &barVertexArray);
+		GLStateCache::Get().BindVertexArray(barVertexArray);
+		setUpBarAttributes();
+		GLStateCache::Get().BindVertexArray(0);
+	}
 
 	bar0.x = -1.0f;
 	bar1.x = +1.0f;
@@ -489,85 +507,102 @@ int main_()
 	//GLuint image = loadBMP_custom("test.bmp");
 	InitTexture(R"(C:\Users\Freis\Desktop\GLFWTest\x64\Debug\cat.raw)");
 
+	// Œ^CXebvB`͒O2Xebv̊ԂԂ
+	FixedTimestep timestep;
+	timestep.SetUp(STEP_HZ);
+	timestep.Start(glfwGetTime());
+	Extent lastBar0 = bar0;
+	Extent lastBar1 = bar1;
+	Extent lastBall = ball;
+
+	// `ԂƂCPU/GPUԂ𐔕bɕ\
+	GpuProfiler profiler;
+	profiler.SetUp(true);
+	int frame = 0;
+
 	// main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		profiler.BeginFrame();
+		profiler.BeginPass("scene");
 		Scene();
+		profiler.EndPass();
 		//LoadTexture("num.png");
 		if(false)
 		{
-			ProcessInputs();
-			UpdateBall();
-
-			float ratio;
-			int width, height;
-			mat4x4 m, p, mvp;
+			const int steps = timestep.Advance(glfwGetTime());
+			for (int i = 0; i < steps; i++)
+			{
+				lastBar0 = bar0;
+				lastBar1 = bar1;
+				lastBall = ball;
+				const int points = scores[0] + scores[1];
+				ProcessInputs();
+				UpdateBall();
+				// X|[͕ԂȂ
+				if (scores[0] + scores[1] != points)
+				{
+					lastBall = ball;
+				}
+			}
+			const float alpha = static_cast<float>(timestep.GetAlpha());
+			const Vec2 bar0Pos = Lerp({ lastBar0.x, lastBar0.y }, { bar0.x, bar0.y }, alpha);
+			const Vec2 bar1Pos = Lerp({ lastBar1.x, lastBar1.y }, { bar1.x, bar1.y }, alpha);
+			const Vec2 ballPos = Lerp({ lastBall.x, lastBall.y }, { ball.x, ball.y }, alpha);
 
-			glfwGetFramebufferSize(window, &width, &height);
-			ratio = static_cast<float>(width) / height;
+			mat4x4 m, mvp;
 
-			glViewport(0, 0, width, height);
 			glClear(GL_COLOR_BUFFER_BIT);
 			glClearColor(0.5f, 0.5f, 0.5f, 1);
 
 			// 1 left bar wsad
-			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[0]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(bar), bar, GL_DYNAMIC_DRAW);
-
-			glEnableVertexAttribArray(vposLocation);
-			glVertexAttribPointer(vposLocation, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(0));
-			glEnableVertexAttribArray(vcolLocation);
-			glVertexAttribPointer(vcolLocation, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
+			profiler.BeginPass("bars");
+			GLStateCache::Get().UseProgram(program);
+			if (barVertexArray != 0)
+			{
+				GLStateCache::Get().BindVertexArray(barVertexArray);
+			}
+			else
+			{
+				setUpBarAttributes();
+			}
 
 			mat4x4_identity(m);
-			mat4x4_translate_in_place(m, bar0.x, bar0.y, 0);
+			mat4x4_translate_in_place(m, bar0Pos.x, bar0Pos.y, 0);
 			//mat4x4_rotate_Z(m, m, (float)glfwGetTime());
-			mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
-			mat4x4_mul(mvp, p, m);
-
-			glUniformMatrix4fv(mvpLocation, 1, false, (const GLfloat*)mvp);
-			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			mat4x4_mul(mvp, camera.GetViewProj(), m);
 
-			// 2 right bar arrows
-			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[1]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(bar), bar, GL_DYNAMIC_DRAW);
+			GLStateCache::Get().UniformMatrix4fv(mvpLocation, (const GLfloat*)mvp);
+			QuadIndexBuffer::Get().Draw(1);
 
+			// 2 right bar arrows (shares the left bar mesh)
 			mat4x4_identity(m);
-			mat4x4_translate_in_place(m, bar1.x, bar1.y, 0);
+			mat4x4_translate_in_place(m, bar1Pos.x, bar1Pos.y, 0);
 			//mat4x4_rotate_Z(m, m, (float)glfwGetTime());
-			mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
-			mat4x4_mul(mvp, p, m);
-
-			glEnableVertexAttribArray(vposLocation);
-			glVertexAttribPointer(vposLocation, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(0));
-			glEnableVertexAttribArray(vcolLocation);
-			glVertexAttribPointer(vcolLocation, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
-
-			glUseProgram(program);
-			glUniformMatrix4fv(mvpLocation, 1, false, (const GLfloat*)mvp);
-			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-			// 4 circle
-			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[3]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(circleVerts), circleVerts, GL_DYNAMIC_DRAW);
-
-			mat4x4_identity(m);
-			mat4x4_translate_in_place(m, ball.x, ball.y, 0);
-			mat4x4_rotate_Z(m, m, (float)glfwGetTime() * 2);
-			mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
-			mat4x4_mul(mvp, p, m);
-
-			glEnableVertexAttribArray(vposLocation);
-			glVertexAttribPointer(vposLocation, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(0));
-			glEnableVertexAttribArray(vcolLocation);
-			glVertexAttribPointer(vcolLocation, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
-
-			glUniformMatrix4fv(mvpLocation, 1, false, (const GLfloat*)mvp);
-			glDrawArrays(GL_TRIANGLE_FAN, 0, CIRCLE_VERTEX_COUNT);
+			mat4x4_mul(mvp, camera.GetViewProj(), m);
+
+			GLStateCache::Get().UseProgram(program);
+			GLStateCache::Get().UniformMatrix4fv(mvpLocation, (const GLfloat*)mvp);
+			QuadIndexBuffer::Get().Draw(1);
+			profiler.EndPass();
+
+			// 4 circle: 4 vertices, the disc and its colours come from the shader
+			profiler.BeginPass("circle");
+			circleBatch.Begin(camera.GetViewProj());
+			circleBatch.Draw(circleMesh, 0, { 0, 0, 1, 1 }, ballPos, { 1, 1 }, (float)glfwGetTime() * 2, { 1, 1, 1, 1 });
+			circleBatch.End();
+			profiler.EndPass();
 		}
 		// end
 		glfwSwapBuffers(window);
 		glfwPollEvents();
+		profiler.EndFrame();
+		pacer.EndFrame();
+		if (++frame % 300 == 0)
+		{
+			profiler.Print(std::cout);
+			pacer.Print(std::cout);
+		}
 	}
 
 	glfwDestroyWindow(window);
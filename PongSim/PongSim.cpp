@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Collision.h"
+#include "MatchFarm.h"
+#include "PongBatch.h"
+#include "PongWorld.h"
+
+
+
+// Runs Pong matches without a window, GLFW or GL, on every hardware
+// thread, for balancing and load tests on machines without a display.
+// Both sides are played by a simple bot.
+
+namespace
+{
+	struct Options
+	{
+		int matches = 1000;
+		int threads = 0;         // MatchFarm threads, 0: all
+		int points = 5;          // a match ends when one side has this many
+		int maxSteps = 60 * 600; // or after ten minutes of game time
+		unsigned int seed = 1;
+		bool batch = false;      // step all matches together with PongBatch
+		bool verify = false;     // run both ways and compare the results
+		bool scaling = false;    // run with 1, 2, 4... threads up to --threads
+	};
+
+	Options ParseOptions(int argc, char* argv[])
+	{
+		Options options;
+		for (int i = 1; i < argc; i++)
+		{
+			const bool hasValue = i + 1 < argc;
+			if (std::strcmp(argv[i], "--matches") == 0 && hasValue)
+			{
+				options.matches = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+			{
+				options.threads = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--points") == 0 && hasValue)
+			{
+				options.points = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--max-steps") == 0 && hasValue)
+			{
+				options.maxSteps = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+			{
+				options.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (std::strcmp(argv[i], "--batch") == 0)
+			{
+				options.batch = true;
+			}
+			else if (std::strcmp(argv[i], "--verify") == 0)
+			{
+				options.verify = true;
+			}
+			else if (std::strcmp(argv[i], "--scaling") == 0)
+			{
+				options.scaling = true;
+			}
+			else
+			{
+				std::cerr << "unknown option " << argv[i] << "\n"
+					<< "usage: " << argv[0] << " [--matches N] [--threads N] [--points N] [--max-steps N] [--seed N] [--batch | --verify | --scaling]\n";
+			}
+		}
+		return options;
+	}
+
+	// follows the ball, but only looks at it every few steps so that it
+	// misses now and then
+	class Bot
+	{
+	public:
+		Bot(unsigned int aUp, unsigned int aDown)
+			: mUp(aUp)
+			, mDown(aDown)
+			, mButtons(0)
+		{
+		}
+
+		unsigned int Update(const Vec2& aBar, const Vec2& aBall, std::mt19937& aRandom)
+		{
+			if (aRandom() % 8 == 0)
+			{
+				const float error = std::uniform_real_distribution<float>(-0.3f, 0.3f)(aRandom);
+				const float offset = aBall.y + error - aBar.y;
+				mButtons = offset > PongWorld::BAR_SPEED ? mUp : offset < -PongWorld::BAR_SPEED ? mDown : 0;
+			}
+			return mButtons;
+		}
+
+	private:
+		unsigned int mUp;
+		unsigned int mDown;
+		unsigned int mButtons;
+	};
+
+	struct MatchResult
+	{
+		int leftPoint;
+		int rightPoint;
+		int steps;
+	};
+
+	// one worker's share of the results, merged after the run
+	struct Totals
+	{
+		long long leftWins;
+		long long rightWins;
+		long long unfinished;
+		long long steps;
+		// keeps the workers' totals on separate cache lines
+		char padding[32];
+
+		void Add(const MatchResult& aResult, int aPoints)
+		{
+			leftWins += aResult.leftPoint >= aPoints;
+			rightWins += aResult.rightPoint >= aPoints;
+			unfinished += aResult.leftPoint < aPoints && aResult.rightPoint < aPoints;
+			steps += aResult.steps;
+		}
+
+		void Merge(const Totals& aOther)
+		{
+			leftWins += aOther.leftWins;
+			rightWins += aOther.rightWins;
+			unfinished += aOther.unfinished;
+			steps += aOther.steps;
+		}
+	};
+
+	// every match has its own serve and bots, so it replays the same with the same seed
+	float Serve(std::mt19937& aRandom)
+	{
+		return std::uniform_real_distribution<float>(30.f, 150.f)(aRandom);
+	}
+
+	MatchResult PlayMatch(const Options& aOptions, long long aMatch)
+	{
+		std::mt19937 random(static_cast<unsigned int>(aOptions.seed + aMatch));
+		PongWorld world;
+		world.SetUp(Serve(random));
+		Bot left(BUTTON_LEFT_UP, BUTTON_LEFT_DOWN);
+		Bot right(BUTTON_RIGHT_UP, BUTTON_RIGHT_DOWN);
+
+		while (world.GetLeftPoint() < aOptions.points && world.GetRightPoint() < aOptions.points
+			&& static_cast<int>(world.GetTick()) < aOptions.maxSteps)
+		{
+			InputFrame input;
+			input.buttons = left.Update(world.GetBar0Pos(), world.GetBallPos(), random)
+				| right.Update(world.GetBar1Pos(), world.GetBallPos(), random);
+			world.Step(input);
+		}
+		return{ world.GetLeftPoint(), world.GetRightPoint(), static_cast<int>(world.GetTick()) };
+	}
+
+	// every match in its own PongWorld, spread over the farm's threads
+	Totals RunMatches(const Options& aOptions, MatchFarm& aFarm, std::vector<MatchResult>* aResults)
+	{
+		std::vector<Totals> workerTotals(aFarm.GetThreadCount(), Totals{});
+		aFarm.Run(aOptions.matches, [&](long long aMatch, int aWorker)
+		{
+			const MatchResult result = PlayMatch(aOptions, aMatch);
+			workerTotals[aWorker].Add(result, aOptions.points);
+			if (aResults != nullptr)
+			{
+				(*aResults)[aMatch] = result;
+			}
+		});
+
+		Totals totals{};
+		for (const auto& worker : workerTotals)
+		{
+			totals.Merge(worker);
+		}
+		return totals;
+	}
+
+	// all matches in lockstep in a PongBatch on one thread; finished ones
+	// keep being stepped with no buttons until the last one ends
+	std::vector<MatchResult> RunBatch(const Options& aOptions, double& aStepSeconds)
+	{
+		const int count = aOptions.matches;
+		PongBatch batch;
+		batch.SetUp(count);
+		std::vector<std::mt19937> randoms;
+		std::vector<Bot> lefts(count, Bot(BUTTON_LEFT_UP, BUTTON_LEFT_DOWN));
+		std::vector<Bot> rights(count, Bot(BUTTON_RIGHT_UP, BUTTON_RIGHT_DOWN));
+		for (int match = 0; match < count; match++)
+		{
+			randoms.emplace_back(aOptions.seed + match);
+			batch.Reset(match, Serve(randoms[match]));
+		}
+
+		std::vector<MatchResult> results(count);
+		std::vector<bool> finished(count, false);
+		std::vector<InputFrame> inputs(count);
+		int runningCount = count;
+		aStepSeconds = 0;
+		for (int step = 1; step <= aOptions.maxSteps && runningCount > 0; step++)
+		{
+			for (int match = 0; match < count; match++)
+			{
+				inputs[match].buttons = finished[match] ? 0
+					: lefts[match].Update(batch.GetBar0Pos(match), batch.GetBallPos(match), randoms[match])
+					| rights[match].Update(batch.GetBar1Pos(match), batch.GetBallPos(match), randoms[match]);
+			}
+
+			const auto stepStart = std::chrono::steady_clock::now();
+			batch.Step(inputs.data());
+			aStepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count();
+
+			for (int match = 0; match < count; match++)
+			{
+				const int leftPoint = batch.GetLeftPoint(match);
+				const int rightPoint = batch.GetRightPoint(match);
+				if (!finished[match] && (leftPoint >= aOptions.points || rightPoint >= aOptions.points || step == aOptions.maxSteps))
+				{
+					results[match] = { leftPoint, rightPoint, step };
+					finished[match] = true;
+					runningCount--;
+				}
+			}
+		}
+		return results;
+	}
+
+	void Print(const Totals& aTotals, int aMatchCount, double aSeconds)
+	{
+		std::cout << aMatchCount << " matches, " << aTotals.steps << " steps in " << aSeconds << " s\n"
+			<< "left " << aTotals.leftWins << ", right " << aTotals.rightWins << ", unfinished " << aTotals.unfinished << "\n"
+			<< aMatchCount / aSeconds << " matches/s, " << aTotals.steps / aSeconds << " steps/s\n";
+	}
+
+	// SweepCircleBox() against a bar-sized box at the origin, for --verify;
+	// returns the number of cases it gets wrong
+	int VerifySweep()
+	{
+		struct SweepCase
+		{
+			const char* name;
+			Vec2 start;
+			Vec2 motion;
+			bool hit;
+			Vec2 normal;
+		};
+		const SweepCase cases[] =
+		{
+			{ "face", { -0.3f, 0.f }, { 0.4f, 0.f }, true, { -1.f, 0.f } },
+			{ "through in one step", { -1.f, 0.f }, { 2.f, 0.f }, true, { -1.f, 0.f } },
+			{ "above", { -0.3f, 0.3f }, { 0.6f, 0.f }, false, {} },
+			{ "corner", { -0.3f, 0.19f }, { 0.6f, 0.f }, true, { -0.5f, 0.87f } },
+			{ "resting on the face, moving off", { 0.1f, 0.f }, { 0.01f, 0.f }, false, {} },
+			{ "in the corner square, moving off", { 0.0636f, 0.1916f }, { 0.28f, 0.05f }, false, {} },
+		};
+		const Vec2 half = { PongWorld::BAR_HIT_HALF_X, PongWorld::BAR_HIT_HALF_Y };
+		int wrongCount = 0;
+		for (const auto& sweepCase : cases)
+		{
+			SweepHit hit;
+			const bool hasHit = SweepCircleBox(sweepCase.start, sweepCase.motion, PongWorld::BALL_HIT_HALF, { 0.f, 0.f }, half, hit);
+			// a normal pointing with the motion is wrong however close it is
+			const bool right = hasHit == sweepCase.hit && (!hasHit
+				|| (std::abs(hit.normal.x - sweepCase.normal.x) < 0.01f && std::abs(hit.normal.y - sweepCase.normal.y) < 0.01f));
+			if (!right)
+			{
+				std::cout << "sweep case \"" << sweepCase.name << "\" is wrong\n";
+				wrongCount++;
+			}
+		}
+		return wrongCount;
+	}
+
+	double Seconds(std::chrono::steady_clock::time_point aStart)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const Options options = ParseOptions(argc, argv);
+	MatchFarm farm;
+	farm.SetUp(options.threads);
+
+	if (options.scaling)
+	{
+		// efficiency: matches/s over (threads * matches/s of one thread)
+		double oneThreadRate = 0;
+		const int maxThreads = farm.GetThreadCount();
+		for (int threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2)
+		{
+			farm.SetUp(threads);
+			const auto startTime = std::chrono::steady_clock::now();
+			RunMatches(options, farm, nullptr);
+			const double rate = options.matches / Seconds(startTime);
+			int stealCount = 0;
+			for (int i = 0; i < threads; i++)
+			{
+				stealCount += farm.GetStatistics(i).stealCount;
+			}
+			oneThreadRate = threads == 1 ? rate : oneThreadRate;
+			std::cout << threads << " threads: " << rate << " matches/s, efficiency "
+				<< 100.0 * rate / (threads * oneThreadRate) << "%, " << stealCount << " steals\n";
+		}
+		return 0;
+	}
+
+	std::vector<MatchResult> results;
+	if (!options.batch || options.verify)
+	{
+		if (options.verify)
+		{
+			results.resize(options.matches);
+		}
+		const auto startTime = std::chrono::steady_clock::now();
+		const Totals totals = RunMatches(options, farm, options.verify ? &results : nullptr);
+		std::cout << farm.GetThreadCount() << " threads\n";
+		Print(totals, options.matches, Seconds(startTime));
+	}
+	if (options.batch || options.verify)
+	{
+		double stepSeconds = 0;
+		const auto startTime = std::chrono::steady_clock::now();
+		const std::vector<MatchResult> batchResults = RunBatch(options, stepSeconds);
+		const double seconds = Seconds(startTime);
+		Totals totals{};
+		for (const auto& result : batchResults)
+		{
+			totals.Add(result, options.points);
+		}
+		std::cout << "batch:\n";
+		Print(totals, options.matches, seconds);
+		// Step() advances every match, finished or not, until the longest one ends
+		int stepCalls = 0;
+		for (const auto& result : batchResults)
+		{
+			stepCalls = std::max(stepCalls, result.steps);
+		}
+		std::cout << "PongBatch::Step() alone: " << static_cast<double>(options.matches) * stepCalls / stepSeconds << " match steps/s\n";
+
+		if (options.verify)
+		{
+			int mismatchCount = 0;
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				mismatchCount += results[i].leftPoint != batchResults[i].leftPoint
+					|| results[i].rightPoint != batchResults[i].rightPoint || results[i].steps != batchResults[i].steps;
+			}
+			std::cout << mismatchCount << " of " << results.size() << " matches differ\n";
+			return mismatchCount == 0 && VerifySweep() == 0 ? 0 : 1;
+		}
+	}
+	return 0;
+}